@@ -8,6 +8,7 @@
 
 #include "crc32c.h"
 #include <stdbool.h>
+#include <string.h>
 
 static uint32_t crc32c_CPUDetection(uint32_t crc, const void* data, size_t length) {
     // Avoid issues that could potentially be caused by multiple threads: use a local variable
@@ -76,6 +77,41 @@ CRC32CFunctionPtr detectBestCRC32C() {
 #endif // ((defined __ppc__) || (defined __ppc64__))
 }
 
+// Kernels may run on several threads at once, so this is set when the library is loaded, before
+// any threads exist.
+int crc32cHardwareState = -1;
+
+int crc32cDetectHardware(void) {
+    int hardware = detectBestCRC32C() != crc32cSlicingBy8;
+#if (defined __GNUC__) || (defined __clang__)
+    __atomic_store_n(&crc32cHardwareState, hardware, __ATOMIC_RELAXED);
+#else
+    crc32cHardwareState = hardware;
+#endif
+    return hardware;
+}
+
+#if (defined __GNUC__) || (defined __clang__)
+__attribute__((constructor)) static void initHardwareCRC32C(void) {
+    crc32cDetectHardware();
+}
+#endif
+
+// Returns true if the CRC32 instruction is available. Kernels that are not called through the
+// crc32c pointer use this to pick an implementation. Caches the answer: cpuid is slow.
+static bool hasHardwareCRC32C(void) {
+#if (defined __GNUC__) || (defined __clang__)
+    int hardware = __atomic_load_n(&crc32cHardwareState, __ATOMIC_RELAXED);
+#else
+    int hardware = crc32cHardwareState;
+#endif
+    if (hardware < 0) {
+        // Called from another constructor, before initHardwareCRC32C
+        hardware = crc32cDetectHardware();
+    }
+    return hardware;
+}
+
 // Implementations adapted from Intel's Slicing By 8 Sourceforge Project
 // http://sourceforge.net/projects/slicing-by-8/
 /*++
@@ -262,4 +298,376 @@ uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length) {
 #endif
 }
 
+#ifdef __LP64__
+// Computes the finished CRCs of 4 independent buffers. A single CRC32 chain is limited by the
+// latency of the instruction; interleaving 4 chains keeps the pipeline full. The lengths may
+// differ: the chains run together over the shortest length, then each tail is finished alone.
+static void crc32cHardware64Batch4(const void* const* data, const size_t* lengths, uint32_t* crcs) {
+    const char* p_buf0 = (const char*) data[0];
+    const char* p_buf1 = (const char*) data[1];
+    const char* p_buf2 = (const char*) data[2];
+    const char* p_buf3 = (const char*) data[3];
+    size_t length = lengths[0];
+    for (int i = 1; i < 4; i++) {
+        if (lengths[i] < length) length = lengths[i];
+    }
+
+    uint64_t crc0 = crc32cInit();
+    uint64_t crc1 = crc32cInit();
+    uint64_t crc2 = crc32cInit();
+    uint64_t crc3 = crc32cInit();
+    size_t words = length / sizeof(uint64_t);
+    for (size_t i = 0; i < words; i++) {
+        crc0 = __builtin_ia32_crc32di(crc0, *(uint64_t*) p_buf0);
+        crc1 = __builtin_ia32_crc32di(crc1, *(uint64_t*) p_buf1);
+        crc2 = __builtin_ia32_crc32di(crc2, *(uint64_t*) p_buf2);
+        crc3 = __builtin_ia32_crc32di(crc3, *(uint64_t*) p_buf3);
+        p_buf0 += sizeof(uint64_t);
+        p_buf1 += sizeof(uint64_t);
+        p_buf2 += sizeof(uint64_t);
+        p_buf3 += sizeof(uint64_t);
+    }
+
+    size_t done = words * sizeof(uint64_t);
+    crcs[0] = crc32cFinish(crc32cHardware64((uint32_t) crc0, p_buf0, lengths[0] - done));
+    crcs[1] = crc32cFinish(crc32cHardware64((uint32_t) crc1, p_buf1, lengths[1] - done));
+    crcs[2] = crc32cFinish(crc32cHardware64((uint32_t) crc2, p_buf2, lengths[2] - done));
+    crcs[3] = crc32cFinish(crc32cHardware64((uint32_t) crc3, p_buf3, lengths[3] - done));
+}
+
+// Copies and checksums in the same pass: each word is loaded once.
+static uint32_t crc32cHardware64Copy(uint32_t crc, void* destination, const void* source,
+        size_t length) {
+    char* p_out = (char*) destination;
+    const char* p_buf = (const char*) source;
+    uint64_t crc64bit = crc;
+    for (size_t i = 0; i < length / sizeof(uint64_t); i++) {
+        uint64_t word = *(uint64_t*) p_buf;
+        crc64bit = __builtin_ia32_crc32di(crc64bit, word);
+        *(uint64_t*) p_out = word;
+        p_buf += sizeof(uint64_t);
+        p_out += sizeof(uint64_t);
+    }
+
+    length &= sizeof(uint64_t) - 1;
+    memcpy(p_out, p_buf, length);
+    return crc32cHardware64((uint32_t) crc64bit, p_buf, length);
+}
+
+// The CRC of each value is a single CRC32 instruction, so one per value is limited by the
+// latency of the instruction: 8 values per iteration keep 8 independent instructions in flight.
+static void crc32cHardwareColumnU32(const uint32_t* in, uint32_t* out, size_t count,
+        uint32_t seed) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        out[i] = __builtin_ia32_crc32si(seed, in[i]);
+        out[i + 1] = __builtin_ia32_crc32si(seed, in[i + 1]);
+        out[i + 2] = __builtin_ia32_crc32si(seed, in[i + 2]);
+        out[i + 3] = __builtin_ia32_crc32si(seed, in[i + 3]);
+        out[i + 4] = __builtin_ia32_crc32si(seed, in[i + 4]);
+        out[i + 5] = __builtin_ia32_crc32si(seed, in[i + 5]);
+        out[i + 6] = __builtin_ia32_crc32si(seed, in[i + 6]);
+        out[i + 7] = __builtin_ia32_crc32si(seed, in[i + 7]);
+    }
+    for (; i < count; i++) {
+        out[i] = __builtin_ia32_crc32si(seed, in[i]);
+    }
+}
+
+static void crc32cHardwareColumnU64(const uint64_t* in, uint32_t* out, size_t count,
+        uint32_t seed) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        out[i] = (uint32_t) __builtin_ia32_crc32di(seed, in[i]);
+        out[i + 1] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 1]);
+        out[i + 2] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 2]);
+        out[i + 3] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 3]);
+        out[i + 4] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 4]);
+        out[i + 5] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 5]);
+        out[i + 6] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 6]);
+        out[i + 7] = (uint32_t) __builtin_ia32_crc32di(seed, in[i + 7]);
+    }
+    for (; i < count; i++) {
+        out[i] = (uint32_t) __builtin_ia32_crc32di(seed, in[i]);
+    }
+}
+#endif // def __LP64__
+
 #endif // !((defined __ppc__) || (defined __ppc64__))
+
+void crc32cBatch(const void* const* data, const size_t* lengths, uint32_t* crcs, size_t count) {
+    size_t i = 0;
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    if (hasHardwareCRC32C()) {
+        for (; i + 4 <= count; i += 4) {
+            crc32cHardware64Batch4(data + i, lengths + i, crcs + i);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        crcs[i] = crc32cFinish(crc32c(crc32cInit(), data[i], lengths[i]));
+    }
+}
+
+size_t crc32cVerifyPages(const void* base, size_t pageSize, size_t count,
+        const uint32_t* expected, uint8_t* mismatchBitmap) {
+    // Pages are checksummed in groups with crc32cBatch, which interleaves independent chains
+    enum { GROUP = 16 };
+    const void* pages[GROUP];
+    size_t lengths[GROUP];
+    uint32_t crcs[GROUP];
+    for (size_t i = 0; i < GROUP; i++) {
+        lengths[i] = pageSize;
+    }
+
+    size_t mismatches = 0;
+    const char* p_buf = (const char*) base;
+    for (size_t first = 0; first < count; first += GROUP) {
+        size_t groupSize = count - first < GROUP ? count - first : (size_t) GROUP;
+        for (size_t i = 0; i < groupSize; i++) {
+            pages[i] = p_buf + (first + i) * pageSize;
+        }
+        crc32cBatch(pages, lengths, crcs, groupSize);
+        for (size_t i = 0; i < groupSize; i++) {
+            size_t page = first + i;
+            int mismatch = crcs[i] != expected[page];
+            mismatches += mismatch;
+            if (mismatchBitmap != NULL) {
+                uint8_t bit = (uint8_t) (1 << (page % 8));
+                if (mismatch) {
+                    mismatchBitmap[page / 8] |= bit;
+                } else {
+                    mismatchBitmap[page / 8] &= (uint8_t) ~bit;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+void crc32cColumnU32(const uint32_t* in, uint32_t* out, size_t count, uint32_t seed) {
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    if (hasHardwareCRC32C()) {
+        crc32cHardwareColumnU32(in, out, count, seed);
+        return;
+    }
+#endif
+    // Slicing by 4, one value per step
+    for (size_t i = 0; i < count; i++) {
+        uint32_t crc = seed ^ in[i];
+        out[i] = crc_tableil8_o56[crc & 0x000000FF] ^
+                crc_tableil8_o48[(crc >> 8) & 0x000000FF] ^
+                crc_tableil8_o40[(crc >> 16) & 0x000000FF] ^
+                crc_tableil8_o32[crc >> 24];
+    }
+}
+
+void crc32cColumnU64(const uint64_t* in, uint32_t* out, size_t count, uint32_t seed) {
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    if (hasHardwareCRC32C()) {
+        crc32cHardwareColumnU64(in, out, count, seed);
+        return;
+    }
+#endif
+    // Slicing by 8, one value per step
+    for (size_t i = 0; i < count; i++) {
+        uint32_t crc = seed ^ (uint32_t) in[i];
+        uint32_t high = (uint32_t) (in[i] >> 32);
+        out[i] = crc_tableil8_o88[crc & 0x000000FF] ^
+                crc_tableil8_o80[(crc >> 8) & 0x000000FF] ^
+                crc_tableil8_o72[(crc >> 16) & 0x000000FF] ^
+                crc_tableil8_o64[crc >> 24] ^
+                crc_tableil8_o56[high & 0x000000FF] ^
+                crc_tableil8_o48[(high >> 8) & 0x000000FF] ^
+                crc_tableil8_o40[(high >> 16) & 0x000000FF] ^
+                crc_tableil8_o32[high >> 24];
+    }
+}
+
+uint32_t crc32cStrided(uint32_t crc, const void* base, size_t rowBytes, size_t pitch,
+        size_t rows) {
+    const char* p_row = (const char*) base;
+    if (pitch == rowBytes) {
+        return crc32c(crc, p_row, rowBytes * rows);
+    }
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    // Call the kernel directly: for short rows the indirect call costs as much as the row
+    if (hasHardwareCRC32C()) {
+        for (size_t i = 0; i < rows; i++) {
+            crc = crc32cHardware64(crc, p_row, rowBytes);
+            p_row += pitch;
+        }
+        return crc;
+    }
+#endif
+    for (size_t i = 0; i < rows; i++) {
+        crc = crc32c(crc, p_row, rowBytes);
+        p_row += pitch;
+    }
+    return crc;
+}
+
+uint32_t crc32cCopy(uint32_t crc, void* destination, const void* source, size_t length) {
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    if (hasHardwareCRC32C()) {
+        return crc32cHardware64Copy(crc, destination, source, length);
+    }
+#endif
+    memcpy(destination, source, length);
+    return crc32c(crc, destination, length);
+}
+
+// CRC arithmetic. The CRC is the remainder of the message polynomial modulo P(x), so appending n
+// zero bytes to a message multiplies its CRC by x^(8n) mod P(x). That product can be computed in
+// O(log n) from crc_shift_table instead of running n zero bytes through a kernel.
+
+// Returns a(x) * b(x) mod P(x), in the reflected bit order of the CRC (x^0 is the high bit).
+// The carry-less product is formed four bits at a time, then its high 32 terms are reduced by
+// running them through four zero bytes with the byte table, which multiplies them by x^32 mod P(x).
+// Only the multiples of b are tabulated, so in a chain of multiplications pass the running
+// value as a: the table is then built off the dependency chain.
+static uint32_t multiplyModP(uint32_t a, uint32_t b) {
+    uint64_t multiples[16];
+    multiples[0] = 0;
+    multiples[1] = b;
+    for (int i = 2; i < 16; i += 2) {
+        multiples[i] = multiples[i / 2] << 1;
+        multiples[i + 1] = multiples[i] ^ b;
+    }
+    uint64_t product = 0;
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        product = (product << 4) ^ multiples[(a >> shift) & 0xf];
+    }
+    // Bit j of product is the coefficient of x^(62 - j): shift so that x^0 is the high bit, then
+    // the high word holds x^0..x^31 and the low word x^32..x^63
+    product <<= 1;
+    uint32_t high = (uint32_t) product;
+    for (int i = 0; i < 4; ++i) {
+        high = crc_tableil8_o32[high & 0xff] ^ (high >> 8);
+    }
+    return (uint32_t) (product >> 32) ^ high;
+}
+
+// Returns x^(8 * length) mod P(x): multiplying a CRC by this appends length zero bytes.
+static uint32_t zerosOperator(uint64_t length) {
+    uint32_t op = 0x80000000; // x^0
+    for (int i = 0; length != 0; ++i, length >>= 1) {
+        if (length & 1) {
+            op = multiplyModP(op, crc_shift_table[i]);
+        }
+    }
+    return op;
+}
+
+// Returns x^(-8 * length) mod P(x): multiplying a CRC by this removes length trailing zero bytes.
+static uint32_t inverseZerosOperator(uint64_t length) {
+    uint32_t op = 0x80000000; // x^0
+    for (int i = 0; length != 0; ++i, length >>= 1) {
+        if (length & 1) {
+            op = multiplyModP(op, crc_unshift_table[i]);
+        }
+    }
+    return op;
+}
+
+uint32_t crc32cPatch(uint32_t crc, size_t totalLength, size_t offset,
+        const void* oldData, const void* newData, size_t length) {
+    const char* p_old = (const char*) oldData;
+    const char* p_new = (const char*) newData;
+
+    // CRC is linear: the change to the CRC is the CRC (with a zero initial value) of the XOR of
+    // the old and new bytes, followed by the bytes after them.
+    char delta[256];
+    uint32_t deltaCrc = 0;
+    while (length > 0) {
+        size_t blockLength = length < sizeof(delta) ? length : sizeof(delta);
+        for (size_t i = 0; i < blockLength; i++) {
+            delta[i] = p_old[i] ^ p_new[i];
+        }
+        deltaCrc = crc32c(deltaCrc, delta, blockLength);
+        p_old += blockLength;
+        p_new += blockLength;
+        offset += blockLength;
+        length -= blockLength;
+    }
+
+    return crc ^ multiplyModP(zerosOperator(totalLength - offset), deltaCrc);
+}
+
+// With finished CRCs, crc(A||B) = crc(A) * x^(8 * length(B)) + crc(B): the initial value and
+// final XOR cancel out.
+
+uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, size_t lengthB) {
+    return multiplyModP(zerosOperator(lengthB), crcA) ^ crcB;
+}
+
+uint32_t crc32cShiftOperator(size_t length) {
+    return zerosOperator(length);
+}
+
+uint32_t crc32cShift(uint32_t crc, uint32_t op) {
+    return multiplyModP(crc, op);
+}
+
+uint32_t crc32cRemovePrefix(uint32_t crcAB, uint32_t crcA, size_t lengthB) {
+    return crcAB ^ multiplyModP(zerosOperator(lengthB), crcA);
+}
+
+uint32_t crc32cRemoveSuffix(uint32_t crcAB, uint32_t crcB, size_t lengthB) {
+    return multiplyModP(inverseZerosOperator(lengthB), crcAB ^ crcB);
+}
+
+// Returns the length of the run of zero bytes at the start of data, up to length.
+static size_t zeroPrefixLength(const char* data, size_t length) {
+    size_t i = 0;
+    // 32 bytes per test, so the loop is limited by loads rather than branches
+    for (; i + 4 * sizeof(uint64_t) <= length; i += 4 * sizeof(uint64_t)) {
+        const uint64_t* words = (const uint64_t*) (data + i);
+        if ((words[0] | words[1] | words[2] | words[3]) != 0) break;
+    }
+    while (i < length && data[i] == 0) {
+        i++;
+    }
+    return i;
+}
+
+uint32_t crc32cDetectZeros(uint32_t crc, const void* data, size_t length, size_t subBlockSize,
+        uint8_t* zeroBitmap, int* allZero) {
+    const char* p_buf = (const char*) data;
+    if (subBlockSize == 0 || subBlockSize > length) subBlockSize = length;
+    uint32_t op = zerosOperator(subBlockSize);
+    int zeros = 1;
+
+    for (size_t block = 0; length > 0; block++) {
+        size_t blockLength = length < subBlockSize ? length : subBlockSize;
+        // Data blocks usually stop the scan in the first word: the block is then still in cache
+        // when it is checksummed
+        int isZero = zeroPrefixLength(p_buf, blockLength) == blockLength;
+        if (!isZero) {
+            crc = crc32c(crc, p_buf, blockLength);
+        } else if (blockLength == subBlockSize) {
+            crc = multiplyModP(crc, op);
+        } else {
+            crc = multiplyModP(zerosOperator(blockLength), crc);
+        }
+        if (zeroBitmap != NULL) {
+            uint8_t bit = (uint8_t) (1 << (block % 8));
+            if (isZero) {
+                zeroBitmap[block / 8] |= bit;
+            } else {
+                zeroBitmap[block / 8] &= (uint8_t) ~bit;
+            }
+        }
+        zeros &= isZero;
+        p_buf += blockLength;
+        length -= blockLength;
+    }
+
+    if (allZero != NULL) *allZero = zeros;
+    return crc;
+}
+
+uint32_t crc32cRemoveSuffixData(uint32_t crcAB, const void* suffix, size_t lengthB) {
+    uint32_t crcB = crc32cFinish(crc32c(crc32cInit(), suffix, lengthB));
+    return crc32cRemoveSuffix(crcAB, crcB, lengthB);
+}
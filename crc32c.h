@@ -35,11 +35,33 @@ extern CRC32CFunctionPtr crc32c;
 
 CRC32CFunctionPtr detectBestCRC32C(void);
 
+/** 1 if the CPU has the CRC32 instruction, 0 if not, or -1 before crc32cDetectHardware() has run,
+which happens when the library is loaded. For inline kernels that cannot call through crc32c; see
+crc32c_word.h. */
+extern int crc32cHardwareState;
+
+/** Detects the CRC32 instruction, stores the answer in crc32cHardwareState and returns it. */
+int crc32cDetectHardware(void);
+
 /** Converts a partial CRC32-C computation to the final value. */
 static inline uint32_t crc32cFinish(uint32_t crc) {
     return ~crc;
 }
 
+/** Returns a masked representation of a finished CRC, for storing alongside the data it covers.
+Computing the CRC of a string that contains embedded CRCs is problematic, so store masked values
+instead. This is the LevelDB/RocksDB mask: rotate right by 15 bits and add a constant.
+*/
+static inline uint32_t crc32cMask(uint32_t crc) {
+    return ((crc >> 15) | (crc << 17)) + 0xa282ead8;
+}
+
+/** Returns the finished CRC whose masked representation is maskedCrc. */
+static inline uint32_t crc32cUnmask(uint32_t maskedCrc) {
+    uint32_t rotated = maskedCrc - 0xa282ead8;
+    return (rotated >> 17) | (rotated << 15);
+}
+
 uint32_t crc32cSarwate(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cSlicingBy4(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cSlicingBy8(uint32_t crc, const void* data, size_t length);
@@ -48,7 +70,107 @@ uint32_t crc32cSlicingBy8(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cHardware32(uint32_t crc, const void* data, size_t length);
 uint32_t crc32cHardware64(uint32_t crc, const void* data, size_t length);
 #endif // !((defined __ppc__) || (defined __ppc64__))
-    
+
+/** Computes the finished CRCs of count independent buffers. Several buffers are checksummed at
+once, which is faster than separate calls when the buffers are short.
+@arg data Pointers to the buffers.
+@arg lengths Length of each buffer in bytes.
+@arg crcs Receives the finished CRC32C of each buffer.
+*/
+void crc32cBatch(const void* const* data, const size_t* lengths, uint32_t* crcs, size_t count);
+
+/** Verifies count pages of pageSize bytes against their finished CRCs. Several pages are
+checksummed at once with interleaved chains, which is faster than a crc32c call per page.
+Returns the number of pages whose CRC does not match.
+@arg base The first page; the pages are contiguous.
+@arg expected The finished CRC32C of each page.
+@arg mismatchBitmap If not NULL, bit i % 8 of mismatchBitmap[i / 8] is set if page i does not
+match, and cleared otherwise. Must hold one bit per page.
+*/
+size_t crc32cVerifyPages(const void* base, size_t pageSize, size_t count,
+        const uint32_t* expected, uint8_t* mismatchBitmap);
+
+/** Computes the CRC of each of count 4 byte values, as stored in memory, for hashing a column of
+keys. out[i] is crc32c(seed, &in[i], 4), but the values are checksummed together so several CRC32
+instructions are in flight at once.
+@arg seed CRC32C value to start each CRC from, such as crc32cInit().
+@arg out Receives the unfinished CRC of each value.
+*/
+void crc32cColumnU32(const uint32_t* in, uint32_t* out, size_t count, uint32_t seed);
+
+/** Computes the CRC of each of count 8 byte values. out[i] is crc32c(seed, &in[i], 8). */
+void crc32cColumnU64(const uint64_t* in, uint32_t* out, size_t count, uint32_t seed);
+
+/** Returns the updated CRC of rows rows of rowBytes bytes each, the first at base and each
+following row pitch bytes after the previous one, as if the rows were concatenated. For
+sub-rectangles of images and tensors, without copying the rows to a contiguous buffer.
+@arg crc Previous CRC32C value, or crc32cInit().
+*/
+uint32_t crc32cStrided(uint32_t crc, const void* base, size_t rowBytes, size_t pitch,
+        size_t rows);
+
+/** Copies length bytes from source to destination and returns the updated CRC of the bytes,
+reading them only once. The buffers must not overlap.
+@arg crc Previous CRC32C value, or crc32cInit().
+*/
+uint32_t crc32cCopy(uint32_t crc, void* destination, const void* source, size_t length);
+
+/** Computes the CRC of length bytes and detects which subBlockSize byte pieces are all zero. Each
+piece is scanned until its first non-zero word; zero pieces are added to the CRC by multiplying by
+a precomputed x^(8 * subBlockSize) mod P(x) instead of being run through the CRC kernel, so
+zero-filled data is much cheaper than separate zero scan and CRC passes.
+@arg crc Previous CRC32C value, or crc32cInit().
+@arg subBlockSize Size of each piece; the last may be shorter. 0 makes the whole buffer one piece.
+@arg zeroBitmap If not NULL, bit i % 8 of zeroBitmap[i / 8] is set if piece i is all zero, and
+cleared otherwise. Must hold one bit per piece.
+@arg allZero If not NULL, set to 1 if every byte is zero, otherwise 0.
+*/
+uint32_t crc32cDetectZeros(uint32_t crc, const void* data, size_t length, size_t subBlockSize,
+        uint8_t* zeroBitmap, int* allZero);
+
+/** Updates a CRC after length bytes at offset in a message are overwritten, without reading the
+rest of the message. Costs O(length + log totalLength). crc may be a finished or unfinished CRC;
+the result is the same kind.
+@arg crc CRC32C of the totalLength byte message, before the change.
+@arg offset Offset of the changed bytes. offset + length must be <= totalLength.
+@arg oldData The bytes before the change.
+@arg newData The bytes after the change.
+*/
+uint32_t crc32cPatch(uint32_t crc, size_t totalLength, size_t offset,
+        const void* oldData, const void* newData, size_t length);
+
+/** Returns the finished CRC of A||B, given the finished CRCs of A and B. Costs O(log lengthB).
+@arg lengthB Length of B in bytes.
+*/
+uint32_t crc32cCombine(uint32_t crcA, uint32_t crcB, size_t lengthB);
+
+/** Returns an operator for crc32cShift that appends length zero bytes. Computing it costs
+O(log length); reuse it when shifting many CRCs by the same length.
+*/
+uint32_t crc32cShiftOperator(size_t length);
+
+/** Multiplies crc by op, from crc32cShiftOperator. For an unfinished CRC this is the CRC after
+appending the zero bytes. For finished CRCs, crc32cCombine(crcA, crcB, lengthB) is
+crc32cShift(crcA, crc32cShiftOperator(lengthB)) ^ crcB.
+*/
+uint32_t crc32cShift(uint32_t crc, uint32_t op);
+
+/** Returns the finished CRC of B, given the finished CRCs of A||B and A. Costs O(log lengthB).
+@arg lengthB Length of B in bytes.
+*/
+uint32_t crc32cRemovePrefix(uint32_t crcAB, uint32_t crcA, size_t lengthB);
+
+/** Returns the finished CRC of A, given the finished CRCs of A||B and B. Costs O(log lengthB).
+@arg lengthB Length of B in bytes.
+*/
+uint32_t crc32cRemoveSuffix(uint32_t crcAB, uint32_t crcB, size_t lengthB);
+
+/** Returns the finished CRC of A, given the finished CRC of A||B and the bytes of B.
+@arg suffix The bytes of B.
+@arg lengthB Length of B in bytes.
+*/
+uint32_t crc32cRemoveSuffixData(uint32_t crcAB, const void* suffix, size_t lengthB);
+
 #if defined(__cplusplus)
 }  // namespace logging
 #endif
@@ -0,0 +1,106 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_assembler.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "crc32c.h"
+
+namespace logging {
+
+Crc32cAssembler::Crc32cAssembler(uint64_t length) : length_(length), covered_(0) {
+}
+
+// Returns the shift operator of length bytes. crc32cShiftOperator() takes a size_t, which is
+// narrower than a segment length on 32-bit targets: longer lengths are the product of pieces.
+static uint32_t shiftOperator(uint64_t length) {
+    size_t piece = (size_t) std::min(length, (uint64_t) SIZE_MAX);
+    uint32_t op = crc32cShiftOperator(piece);
+    for (length -= piece; length > 0; length -= piece) {
+        piece = (size_t) std::min(length, (uint64_t) SIZE_MAX);
+        op = crc32cShift(op, crc32cShiftOperator(piece));
+    }
+    return op;
+}
+
+void Crc32cAssembler::append(Run* run, const Run& next) {
+    run->crc = crc32cShift(run->crc, next.op) ^ next.crc;
+    run->op = crc32cShift(run->op, next.op);
+    run->length += next.length;
+}
+
+bool Crc32cAssembler::add(uint64_t offset, uint64_t length, uint32_t crc) {
+    if (offset > length_ || length > length_ - offset) return false;
+    if (length == 0) return true;
+    // The expensive part, done without the lock
+    Run run = { length, crc, shiftOperator(length) };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // The first run after the segment, and the run before it
+    std::map<uint64_t, Run>::iterator next = runs_.lower_bound(offset);
+    if (next != runs_.end() && next->first < offset + length) return false;
+    std::map<uint64_t, Run>::iterator previous = runs_.end();
+    if (next != runs_.begin()) {
+        previous = next;
+        --previous;
+        if (previous->first + previous->second.length > offset) return false;
+    }
+
+    // crc(AB) = crc(A) * x^(8 * length(B)) + crc(B), and the operator of AB is the product of
+    // the operators of A and B
+    std::map<uint64_t, Run>::iterator merged;
+    if (previous != runs_.end() && previous->first + previous->second.length == offset) {
+        merged = previous;
+        append(&merged->second, run);
+    } else {
+        merged = runs_.insert(next, std::make_pair(offset, run));
+    }
+    if (next != runs_.end() && offset + length == next->first) {
+        append(&merged->second, next->second);
+        runs_.erase(next);
+    }
+
+    covered_ += length;
+    if (covered_ == length_) {
+        lock.unlock();
+        completed_.notify_all();
+    }
+    return true;
+}
+
+bool Crc32cAssembler::complete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return covered_ == length_;
+}
+
+bool Crc32cAssembler::crc(uint32_t* crc) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (covered_ != length_) return false;
+    *crc = runs_.empty() ? 0 : runs_.begin()->second.crc;
+    return true;
+}
+
+uint32_t Crc32cAssembler::wait() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (covered_ != length_) {
+        completed_.wait(lock);
+    }
+    return runs_.empty() ? 0 : runs_.begin()->second.crc;
+}
+
+uint64_t Crc32cAssembler::coveredLength() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return covered_;
+}
+
+size_t Crc32cAssembler::numRuns() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return runs_.size();
+}
+
+}  // namespace logging
@@ -0,0 +1,70 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_ASSEMBLER_H__
+#define LOGGING_CRC32C_ASSEMBLER_H__
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+namespace logging {
+
+// Computes the CRC32C of an object from the CRCs of its segments, which may arrive in any order
+// from any number of threads, for example from a parallel download. The data is not needed.
+//
+// Submitted segments are merged with their neighbours as they arrive, so the assembler holds
+// one entry per contiguous run of received data. Each run keeps its shift operator
+// (x^(8 * length) mod P(x)), and a segment's operator is computed before the lock is taken, so
+// a merge under the lock costs a few carry-less multiplications regardless of the lengths. The
+// whole object CRC is available as soon as the last segment arrives.
+class Crc32cAssembler {
+public:
+    // Assembles an object of length bytes.
+    explicit Crc32cAssembler(uint64_t length);
+
+    // Adds the finished CRC of bytes [offset, offset + length). Returns false, and ignores the
+    // segment, if it extends past the end of the object or overlaps a segment already added.
+    bool add(uint64_t offset, uint64_t length, uint32_t crc);
+
+    // Returns true if every byte of the object has been added.
+    bool complete() const;
+
+    // If the object is complete, sets *crc to its finished CRC and returns true.
+    bool crc(uint32_t* crc) const;
+
+    // Waits until the object is complete and returns its finished CRC.
+    uint32_t wait() const;
+
+    uint64_t length() const { return length_; }
+    // Returns the number of bytes added so far.
+    uint64_t coveredLength() const;
+    // Returns the number of contiguous runs of added data.
+    size_t numRuns() const;
+
+private:
+    // A contiguous run of added data
+    struct Run {
+        uint64_t length;
+        // Finished CRC of the run
+        uint32_t crc;
+        // x^(8 * length) mod P(x)
+        uint32_t op;
+    };
+
+    // Extends run with the run that follows it.
+    static void append(Run* run, const Run& next);
+
+    uint64_t length_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable completed_;
+    // Runs by offset; adjacent runs are always merged
+    std::map<uint64_t, Run> runs_;
+    uint64_t covered_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,297 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "crc32c.h"
+#include "crc32c_file.h"
+#include "crc32c_hash.h"
+#include "crc32c_internal.h"
+
+namespace logging {
+
+// File layout: a HEADER_SIZE byte header then numSlots entries of ENTRY_SIZE bytes.
+//
+// Header:
+//   offset size
+//        0    8  magic "CRC32CCA"
+//        8    4  version (1)
+//       12    4  number of slots
+//       16    4  finished CRC32C of bytes [0, 16)
+//
+// Entry, all fields native byte order; an all zero entry is empty:
+//        0    8  device
+//        8    8  inode
+//       16    8  size
+//       24    8  mtime in nanoseconds
+//       32    8  ctime in nanoseconds
+//       40    4  finished CRC32C of the file
+//       44    4  crc32cMask() of the finished CRC32C of bytes [0, 44) of the entry
+static const char MAGIC[8] = { 'C', 'R', 'C', '3', '2', 'C', 'C', 'A' };
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 64;
+static const size_t HEADER_CRC_OFFSET = 16;
+
+const uint32_t Crc32cCache::DEFAULT_NUM_SLOTS;
+const size_t Crc32cCache::BUCKET_SIZE;
+const int64_t Crc32cCache::DEFAULT_RACY_NANOS;
+
+namespace {
+
+struct Entry {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtimeNanos;
+    int64_t ctimeNanos;
+    uint32_t crc;
+    uint32_t entryCrc;
+};
+
+}  // namespace
+
+static const size_t ENTRY_CRC_OFFSET = 44;
+
+static int64_t nanos(const struct timespec& time) {
+    return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void makeKey(const struct stat& st, Entry* entry) {
+    memset(entry, 0, sizeof(*entry));
+    entry->device = st.st_dev;
+    entry->inode = st.st_ino;
+    entry->size = st.st_size;
+#ifdef __APPLE__
+    entry->mtimeNanos = nanos(st.st_mtimespec);
+    entry->ctimeNanos = nanos(st.st_ctimespec);
+#else
+    entry->mtimeNanos = nanos(st.st_mtim);
+    entry->ctimeNanos = nanos(st.st_ctim);
+#endif
+}
+
+static bool sameKey(const Entry& a, const Entry& b) {
+    return a.device == b.device && a.inode == b.inode && a.size == b.size &&
+            a.mtimeNanos == b.mtimeNanos && a.ctimeNanos == b.ctimeNanos;
+}
+
+static bool isValid(const Entry& entry) {
+    return crc32cMask(oneshot(&entry, ENTRY_CRC_OFFSET)) == entry.entryCrc;
+}
+
+static bool validHeader(const char* header, uint32_t* numSlots) {
+    if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0) return false;
+    uint32_t value;
+    memcpy(&value, header + HEADER_CRC_OFFSET, sizeof(value));
+    if (value != oneshot(header, HEADER_CRC_OFFSET)) return false;
+    memcpy(&value, header + 8, sizeof(value));
+    if (value != VERSION) return false;
+    memcpy(numSlots, header + 12, sizeof(*numSlots));
+    return *numSlots >= Crc32cCache::BUCKET_SIZE;
+}
+
+// Creates an empty cache in the new, empty file fd.
+static bool initialize(int fd, uint32_t numSlots) {
+    if (ftruncate(fd, HEADER_SIZE + (off_t) numSlots * sizeof(Entry)) != 0) return false;
+    char header[HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    memcpy(header + 8, &VERSION, sizeof(VERSION));
+    memcpy(header + 12, &numSlots, sizeof(numSlots));
+    uint32_t crc = oneshot(header, HEADER_CRC_OFFSET);
+    memcpy(header + HEADER_CRC_OFFSET, &crc, sizeof(crc));
+    return pwrite(fd, header, sizeof(header), 0) == (ssize_t) sizeof(header);
+}
+
+Crc32cCache::Crc32cCache(int64_t racyNanos) :
+        racyNanos_(racyNanos), fd_(-1), map_(NULL), mapLength_(0), numSlots_(0) {
+}
+
+Crc32cCache::~Crc32cCache() {
+    close();
+}
+
+void Crc32cCache::close() {
+    if (map_ != NULL) munmap(map_, mapLength_);
+    if (fd_ >= 0) ::close(fd_);
+    map_ = NULL;
+    fd_ = -1;
+    numSlots_ = 0;
+}
+
+// Opens path, creating it if needed, and takes the exclusive lock. Retries if the file is
+// replaced while waiting for the lock, so the lock is held on the file that path names.
+static int openLocked(const std::string& path) {
+    while (true) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd < 0) return -1;
+        struct stat opened;
+        struct stat current;
+        if (flock(fd, LOCK_EX) != 0 || fstat(fd, &opened) != 0) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            return -1;
+        }
+        if (stat(path.c_str(), &current) == 0 && current.st_dev == opened.st_dev &&
+                current.st_ino == opened.st_ino) {
+            return fd;
+        }
+        ::close(fd);
+    }
+}
+
+// Replaces the cache file at path, whose old file is open and locked as *fd, with an empty cache
+// of numSlots entries. On success *fd is the new file, locked; the old one is closed.
+static bool replace(const std::string& path, uint32_t numSlots, int* fd) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp.%d", (int) getpid());
+    std::string temporary = path + suffix;
+    int newFd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (newFd < 0) return false;
+    if (flock(newFd, LOCK_EX) != 0 || !initialize(newFd, numSlots) ||
+            rename(temporary.c_str(), path.c_str()) != 0) {
+        int error = errno;
+        ::close(newFd);
+        unlink(temporary.c_str());
+        errno = error;
+        return false;
+    }
+    ::close(*fd);
+    *fd = newFd;
+    return true;
+}
+
+bool Crc32cCache::open(const std::string& path, uint32_t numSlots) {
+    close();
+    if (numSlots < BUCKET_SIZE) {
+        errno = EINVAL;
+        return false;
+    }
+    int fd = openLocked(path);
+    if (fd < 0) return false;
+
+    // Another process may be creating the file: validate it under the lock
+    struct stat st;
+    char header[HEADER_SIZE];
+    uint32_t existingSlots;
+    bool success = fstat(fd, &st) == 0;
+    if (success && ((size_t) st.st_size < HEADER_SIZE ||
+            pread(fd, header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+            !validHeader(header, &existingSlots) ||
+            (uint64_t) st.st_size != HEADER_SIZE + (uint64_t) existingSlots * sizeof(Entry))) {
+        // Other processes may have the old file mapped, and would get SIGBUS if it shrank under
+        // them: build a new file and rename it into place, still holding the lock on the old one
+        success = replace(path, numSlots, &fd);
+        existingSlots = numSlots;
+    }
+    size_t mapLength = HEADER_SIZE + (size_t) existingSlots * sizeof(Entry);
+    void* map = MAP_FAILED;
+    if (success) {
+        map = mmap(NULL, mapLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        success = map != MAP_FAILED;
+    }
+    int error = errno;
+    flock(fd, LOCK_UN);
+    if (!success) {
+        ::close(fd);
+        errno = error;
+        return false;
+    }
+
+    fd_ = fd;
+    map_ = (char*) map;
+    mapLength_ = mapLength;
+    numSlots_ = existingSlots;
+    return true;
+}
+
+bool Crc32cCache::lookup(const struct stat& st, uint32_t* crc) const {
+    if (map_ == NULL) return false;
+    Entry key;
+    makeKey(st, &key);
+    size_t first = crc32cHashInteger(key.inode, key.device) % (numSlots_ - BUCKET_SIZE + 1);
+    const char* slots = map_ + HEADER_SIZE;
+    for (size_t i = first; i < first + BUCKET_SIZE; ++i) {
+        // Copy the entry out of the shared mapping before validating it: it may change
+        Entry entry;
+        memcpy(&entry, slots + i * sizeof(Entry), sizeof(entry));
+        if (sameKey(entry, key) && isValid(entry)) {
+            *crc = entry.crc;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Crc32cCache::insert(const struct stat& st, uint32_t crc) {
+    if (map_ == NULL) return false;
+    Entry entry;
+    makeKey(st, &entry);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (nanos(now) - entry.mtimeNanos < racyNanos_ || nanos(now) - entry.ctimeNanos < racyNanos_) {
+        return false;
+    }
+    entry.crc = crc;
+    entry.entryCrc = crc32cMask(oneshot(&entry, ENTRY_CRC_OFFSET));
+
+    // Replace an entry for the same file, or use an empty or invalid slot. When the bucket is
+    // full, the hash of the key picks the victim
+    uint64_t hash = crc32cHashInteger(entry.inode, entry.device);
+    size_t first = hash % (numSlots_ - BUCKET_SIZE + 1);
+    char* slots = map_ + HEADER_SIZE;
+    if (flock(fd_, LOCK_EX) != 0) return false;
+    size_t slot = first + (hash >> 32) % BUCKET_SIZE;
+    for (size_t i = first; i < first + BUCKET_SIZE; ++i) {
+        Entry existing;
+        memcpy(&existing, slots + i * sizeof(Entry), sizeof(existing));
+        if (!isValid(existing) ||
+                (existing.device == entry.device && existing.inode == entry.inode)) {
+            slot = i;
+            break;
+        }
+    }
+    memcpy(slots + slot * sizeof(Entry), &entry, sizeof(entry));
+    flock(fd_, LOCK_UN);
+    return true;
+}
+
+bool Crc32cCache::insertIfUnchanged(const struct stat& st, int fd, uint32_t crc) {
+    struct stat after;
+    Entry before;
+    Entry now;
+    makeKey(st, &before);
+    if (fstat(fd, &after) != 0) return false;
+    makeKey(after, &now);
+    if (!sameKey(before, now)) return false;
+    return insert(st, crc);
+}
+
+bool crc32cFileCached(int fd, Crc32cCache* cache, uint32_t* crc, bool* hit) {
+    if (hit != NULL) *hit = false;
+    struct stat st;
+    if (cache == NULL || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return crc32cFile(fd, crc);
+    }
+    if (cache->lookup(st, crc)) {
+        if (hit != NULL) *hit = true;
+        return true;
+    }
+    if (!crc32cFile(fd, crc)) return false;
+    cache->insertIfUnchanged(st, fd, *crc);
+    return true;
+}
+
+}  // namespace logging
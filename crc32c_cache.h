@@ -0,0 +1,75 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_CACHE_H__
+#define LOGGING_CRC32C_CACHE_H__
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+namespace logging {
+
+// A persistent cache of file CRCs, so unchanged files are not read again. Entries are keyed by
+// (device, inode, size, mtime, ctime): any change to the file changes its ctime, so a file whose
+// key matches still has the stored CRC.
+//
+// The cache is a fixed size hash table in a memory mapped file, in native byte order. Each file
+// maps to a bucket of BUCKET_SIZE slots; when the bucket is full, an entry is overwritten, so the
+// cache never grows. Several processes may use the same cache at once: inserts take an exclusive
+// flock(), and lookups take no lock. Every entry includes a CRC of its fields, so a lookup that
+// races with an insert sees a torn entry as a miss.
+//
+// A file modified within the timestamp granularity of the file system after it was checksummed
+// keeps the same timestamps. Like git's "racily clean" entries, files whose mtime or ctime is
+// within racyNanos of the time of insertion are not cached.
+class Crc32cCache {
+public:
+    static const uint32_t DEFAULT_NUM_SLOTS = 1 << 16;
+    static const size_t BUCKET_SIZE = 8;
+    static const int64_t DEFAULT_RACY_NANOS = 2000000000;
+
+    explicit Crc32cCache(int64_t racyNanos = DEFAULT_RACY_NANOS);
+    ~Crc32cCache();
+
+    // Opens the cache file at path, creating it with numSlots entries if it does not exist or is
+    // not a valid cache. Returns false and sets errno on error.
+    bool open(const std::string& path, uint32_t numSlots = DEFAULT_NUM_SLOTS);
+
+    // Returns true and sets *crc to the finished CRC of the file described by st, if cached.
+    bool lookup(const struct stat& st, uint32_t* crc) const;
+
+    // Stores the finished CRC of the file described by st, which must have been fetched before
+    // the file was read. Returns false if the entry was not stored because the file is racy.
+    bool insert(const struct stat& st, uint32_t crc);
+    // Stores the CRC like insert(), but only if the open file fd still matches st: a file that
+    // changed while it was read is not cached.
+    bool insertIfUnchanged(const struct stat& st, int fd, uint32_t crc);
+
+    uint32_t numSlots() const { return numSlots_; }
+
+private:
+    // Not copyable
+    Crc32cCache(const Crc32cCache&);
+    Crc32cCache& operator=(const Crc32cCache&);
+
+    void close();
+
+    int64_t racyNanos_;
+    int fd_;
+    char* map_;
+    size_t mapLength_;
+    uint32_t numSlots_;
+};
+
+// Computes the finished CRC32C of the file fd with crc32cFile, or returns it from cache if cache
+// is not NULL. Updates the cache after computing a CRC. If hit is not NULL, it is set to true if
+// the CRC came from the cache. Returns false and sets errno on error.
+bool crc32cFileCached(int fd, Crc32cCache* cache, uint32_t* crc, bool* hit = 0);
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,77 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_checksummed_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "crc32c.h"
+
+namespace logging {
+
+ChecksummedBuffer::ChecksummedBuffer(size_t length, size_t blockSize) :
+        blockSize_(blockSize), data_(length), crc_(0) {
+    assert(blockSize_ > 0);
+    size_t numBlocks = (length + blockSize_ - 1) / blockSize_;
+    blockCrcs_.resize(numBlocks);
+    shiftOperators_.resize(numBlocks);
+    isDirty_.resize(numBlocks);
+
+    // Nothing follows the last block. Each earlier block is followed by one more block: multiply
+    // the operators, instead of computing each one from its length.
+    if (numBlocks > 0) {
+        uint32_t blockOperator = crc32cShiftOperator(blockSize_);
+        size_t lastLength = length - (numBlocks - 1) * blockSize_;
+        shiftOperators_[numBlocks - 1] = crc32cShiftOperator(0);
+        if (numBlocks > 1) {
+            shiftOperators_[numBlocks - 2] = crc32cShiftOperator(lastLength);
+            for (size_t i = numBlocks - 2; i-- > 0;) {
+                shiftOperators_[i] = crc32cShift(shiftOperators_[i + 1], blockOperator);
+            }
+        }
+    }
+
+    // The total is linear in the block CRCs, so starting from all zero block CRCs and a zero
+    // total is consistent: marking every block dirty computes the real values on first use.
+    markDirty(0, length);
+}
+
+void ChecksummedBuffer::write(size_t offset, const void* data, size_t length) {
+    memcpy(mutableData(offset, length), data, length);
+}
+
+char* ChecksummedBuffer::mutableData(size_t offset, size_t length) {
+    markDirty(offset, length);
+    return data_.data() + offset;
+}
+
+void ChecksummedBuffer::markDirty(size_t offset, size_t length) {
+    assert(offset <= data_.size() && length <= data_.size() - offset);
+    if (length == 0) return;
+    size_t last = (offset + length - 1) / blockSize_;
+    for (size_t block = offset / blockSize_; block <= last; ++block) {
+        if (!isDirty_[block]) {
+            isDirty_[block] = true;
+            dirtyBlocks_.push_back(block);
+        }
+    }
+}
+
+uint32_t ChecksummedBuffer::crc() {
+    for (size_t i = 0; i < dirtyBlocks_.size(); ++i) {
+        size_t block = dirtyBlocks_[i];
+        size_t offset = block * blockSize_;
+        size_t length = std::min(blockSize_, data_.size() - offset);
+        uint32_t blockCrc = crc32cFinish(crc32c(crc32cInit(), &data_[offset], length));
+        crc_ ^= crc32cShift(blockCrc ^ blockCrcs_[block], shiftOperators_[block]);
+        blockCrcs_[block] = blockCrc;
+        isDirty_[block] = false;
+    }
+    dirtyBlocks_.clear();
+    return crc_;
+}
+
+}  // namespace logging
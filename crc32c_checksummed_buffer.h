@@ -0,0 +1,62 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_CHECKSUMMED_BUFFER_H__
+#define LOGGING_CRC32C_CHECKSUMMED_BUFFER_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace logging {
+
+// A mutable byte buffer that keeps its CRC32C up to date lazily. Writes mark fixed size blocks
+// dirty; crc() recomputes only the dirty blocks, so its cost is proportional to the amount of
+// data modified since the last call, not to the size of the buffer.
+//
+// For finished CRCs, the CRC of the buffer is the XOR over all blocks of each block's CRC shifted
+// past the bytes that follow it. When a block changes, XORing in the shifted difference between
+// its old and new CRCs updates the total. The shift operator of each block is precomputed, so
+// this costs 8 bytes per block in addition to the data.
+class ChecksummedBuffer {
+public:
+    // Creates a buffer of length zero bytes.
+    ChecksummedBuffer(size_t length, size_t blockSize);
+
+    size_t length() const { return data_.size(); }
+    size_t blockSize() const { return blockSize_; }
+    const char* data() const { return data_.data(); }
+
+    // Copies length bytes from data to offset in the buffer.
+    void write(size_t offset, const void* data, size_t length);
+
+    // Returns a pointer to bytes [offset, offset + length) for writing, and marks them dirty.
+    // The pointer must not be used to modify bytes outside that range, or after the next call
+    // to crc().
+    char* mutableData(size_t offset, size_t length);
+
+    // Marks bytes [offset, offset + length) as modified.
+    void markDirty(size_t offset, size_t length);
+
+    // Returns the finished CRC of the buffer, recomputing the dirty blocks.
+    uint32_t crc();
+
+    // Returns the number of blocks the next call to crc() will recompute.
+    size_t numDirtyBlocks() const { return dirtyBlocks_.size(); }
+
+private:
+    size_t blockSize_;
+    std::vector<char> data_;
+    // Finished CRC of each block, as of the last call to crc()
+    std::vector<uint32_t> blockCrcs_;
+    // shiftOperators_[i] moves a CRC past the bytes after block i
+    std::vector<uint32_t> shiftOperators_;
+    std::vector<bool> isDirty_;
+    std::vector<size_t> dirtyBlocks_;
+    uint32_t crc_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,118 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_chunker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace logging {
+
+const size_t Crc32cChunker::WINDOW;
+
+Crc32cChunker::Crc32cChunker(size_t minSize, size_t avgSize, size_t maxSize) :
+        rolling_(WINDOW), minSize_(minSize), maxSize_(maxSize), mask_(0) {
+    assert(WINDOW <= minSize && minSize <= avgSize && avgSize <= maxSize);
+    while (((uint64_t) mask_ << 1 | 1) <= avgSize - minSize && mask_ != 0xFFFFFFFF) {
+        mask_ = mask_ << 1 | 1;
+    }
+    reset();
+}
+
+void Crc32cChunker::reset() {
+    chunkOffset_ = 0;
+    chunkLength_ = 0;
+    chunkCrc_ = crc32cInit();
+    memset(history_, 0, sizeof(history_));
+}
+
+uint32_t Crc32cChunker::windowCrc(const char* data, size_t end) const {
+    if (end >= WINDOW) {
+        return rolling_.start(data + end - WINDOW);
+    }
+    // history_[i] is the byte WINDOW - i bytes before data
+    uint32_t crc = crc32c(crc32cInit(), history_ + end, WINDOW - end);
+    crc = crc32c(crc, data, end);
+    return crc32cFinish(crc);
+}
+
+size_t Crc32cChunker::findBoundary(const char* data, size_t eMin, size_t eLimit) const {
+    size_t e = eMin;
+
+    // Windows that reach back into the previous call: roll one byte at a time
+    if (e < WINDOW && e < eLimit) {
+        uint32_t crc = windowCrc(data, e);
+        while (true) {
+            if (isBoundary(crc)) return e;
+            e += 1;
+            if (e >= eLimit || e >= WINDOW) break;
+            crc = rolling_.roll(crc, history_[e - 1], data[e - 1]);
+        }
+    }
+
+    // Windows entirely inside data: tested as they are rolled, in interleaved chains
+    if (e >= eLimit) return eLimit;
+    size_t found = rolling_.findMasked(data + e - WINDOW, eLimit - e + WINDOW - 1, mask_);
+    return found == RollingCrc32c::NOT_FOUND ? eLimit : e + found;
+}
+
+size_t Crc32cChunker::update(const void* data, size_t length, std::vector<Crc32cChunk>* chunks) {
+    const char* p_buf = (const char*) data;
+    size_t numChunks = 0;
+
+    // The current chunk has prior bytes before p_buf[base]
+    size_t base = 0;
+    size_t prior = chunkLength_;
+    while (true) {
+        size_t eMin = base + (prior < minSize_ ? minSize_ - prior : 1);
+        size_t eMax = base + (maxSize_ - prior);
+        if (eMin > length) break;
+
+        // A chunk may end at any e in [eMin, eEnd]
+        size_t eEnd = std::min(eMax, length);
+        size_t e = findBoundary(p_buf, eMin, eEnd + 1);
+        if (e > eEnd) {
+            if (eEnd < eMax) break;
+            e = eMax;
+        }
+
+        // The chunk's bytes were just scanned, so they are still in cache
+        Crc32cChunk chunk;
+        chunk.offset = chunkOffset_;
+        chunk.length = prior + (e - base);
+        chunk.crc = crc32cFinish(crc32c(chunkCrc_, p_buf + base, e - base));
+        chunks->push_back(chunk);
+        numChunks += 1;
+
+        chunkOffset_ += chunk.length;
+        chunkCrc_ = crc32cInit();
+        base = e;
+        prior = 0;
+    }
+
+    chunkCrc_ = crc32c(chunkCrc_, p_buf + base, length - base);
+    chunkLength_ = prior + (length - base);
+
+    if (length >= WINDOW) {
+        memcpy(history_, p_buf + length - WINDOW, WINDOW);
+    } else {
+        memmove(history_, history_ + length, WINDOW - length);
+        memcpy(history_ + WINDOW - length, p_buf, length);
+    }
+    return numChunks;
+}
+
+bool Crc32cChunker::finish(Crc32cChunk* chunk) {
+    bool hasChunk = chunkLength_ > 0;
+    if (hasChunk) {
+        chunk->offset = chunkOffset_;
+        chunk->length = chunkLength_;
+        chunk->crc = crc32cFinish(chunkCrc_);
+    }
+    reset();
+    return hasChunk;
+}
+
+}  // namespace logging
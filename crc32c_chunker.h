@@ -0,0 +1,85 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_CHUNKER_H__
+#define LOGGING_CRC32C_CHUNKER_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "crc32c_rolling.h"
+
+namespace logging {
+
+// One chunk of a stream.
+struct Crc32cChunk {
+    // Offset of the first byte of the chunk in the stream.
+    uint64_t offset;
+    size_t length;
+    // Finished CRC32C of the chunk's bytes.
+    uint32_t crc;
+};
+
+// Splits a stream into content-defined chunks for deduplication, and computes the CRC32C of each
+// chunk in the same pass.
+//
+// A chunk ends after a byte where the rolling CRC32C of the last WINDOW bytes has its low bits
+// clear. Boundaries only depend on nearby content, so inserting or removing bytes only changes
+// the chunks around the edit. No boundary is placed before minSize bytes, so the first
+// minSize - WINDOW bytes of each chunk are not scanned at all; a chunk is cut at maxSize bytes
+// if no boundary is found.
+//
+// The scan rolls the window CRC once per byte, so it is limited by the throughput of the CRC32
+// instruction, one byte per cycle: chunking runs at about one cycle per byte in
+// crc32c_chunker_bench, a few GB/s, against about 0.2 cycles per byte to checksum fixed size
+// chunks.
+class Crc32cChunker {
+public:
+    // Size of the rolling window used to find boundaries.
+    static const size_t WINDOW = 48;
+
+    // Requires WINDOW <= minSize <= avgSize <= maxSize. The expected chunk size is about
+    // avgSize: minSize plus the largest power of two that is <= avgSize - minSize + 1.
+    Crc32cChunker(size_t minSize, size_t avgSize, size_t maxSize);
+
+    // Chunks the next length bytes of the stream, appending completed chunks to chunks.
+    // Returns the number of chunks appended. data only needs to remain valid during the call.
+    size_t update(const void* data, size_t length, std::vector<Crc32cChunk>* chunks);
+
+    // Ends the stream. If there are bytes after the last boundary, stores the final (short)
+    // chunk in chunk and returns true. The chunker is then reset for a new stream.
+    bool finish(Crc32cChunk* chunk);
+
+    // Discards any partial chunk and starts a new stream at offset 0.
+    void reset();
+
+private:
+    // Returns the CRC of the window ending before data[end], which may reach back into the
+    // bytes of the previous call saved in history_.
+    uint32_t windowCrc(const char* data, size_t end) const;
+
+    // Returns the end of the first boundary at or after eMin and before eLimit, or eLimit.
+    size_t findBoundary(const char* data, size_t eMin, size_t eLimit) const;
+
+    bool isBoundary(uint32_t crc) const { return (crc & mask_) == 0; }
+
+    RollingCrc32c rolling_;
+    size_t minSize_;
+    size_t maxSize_;
+    uint32_t mask_;
+
+    // Offset of the current chunk in the stream.
+    uint64_t chunkOffset_;
+    // Bytes of the current chunk seen so far.
+    size_t chunkLength_;
+    // Unfinished CRC of those bytes.
+    uint32_t chunkCrc_;
+    // The last WINDOW bytes of the stream.
+    char history_[WINDOW];
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,130 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_file.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "crc32c.h"
+
+namespace logging {
+
+// Data is read in pieces of this size
+static const size_t READ_SIZE = 1 << 20;
+
+// Finds the data extent at or after *start: sets *start and *end to its bounds, which are clipped
+// to limit. If the file now ends before limit and has no more data, sets both to the end of the
+// file, or leaves them at *start if that is past it. Returns false on error. Without SEEK_DATA
+// support the whole range is one extent.
+static bool nextDataExtent(int fd, uint64_t* start, uint64_t* end, uint64_t limit) {
+#ifdef SEEK_DATA
+    off_t data = lseek(fd, (off_t) *start, SEEK_DATA);
+    if (data < 0) {
+        // ENXIO: there is no data after start, or start is past the end of the file. The file
+        // may have been truncated since limit was computed
+        if (errno == ENXIO) {
+            struct stat st;
+            if (fstat(fd, &st) != 0) return false;
+            *start = *end = std::max(std::min((uint64_t) st.st_size, limit), *start);
+            return true;
+        }
+        if (errno != EINVAL && errno != ENOTSUP) return false;
+    } else {
+        *start = std::min((uint64_t) data, limit);
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) return false;
+        *end = std::min((uint64_t) hole, limit);
+        return true;
+    }
+#else
+    (void) fd;
+#endif
+    *end = limit;
+    return true;
+}
+
+// Adds up to length bytes at offset to crc, which is not finished. Returns the number of bytes
+// read, which is less than length only at the end of the file, or -1 on error.
+static int64_t crcData(int fd, uint64_t offset, uint64_t length, char* buffer, uint32_t* crc) {
+    uint64_t total = 0;
+    while (total < length) {
+        size_t pieceLength = (size_t) std::min((uint64_t) READ_SIZE, length - total);
+        ssize_t bytes = pread(fd, buffer, pieceLength, (off_t) (offset + total));
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (bytes == 0) break;
+        *crc = crc32c(*crc, buffer, bytes);
+        total += bytes;
+    }
+    return total;
+}
+
+bool crc32cFileRange(int fd, uint64_t offset, uint64_t length, uint32_t* crc,
+        uint64_t* checksummedLength) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    uint64_t fileLength = st.st_size;
+    uint64_t end = offset;
+    if (offset < fileLength) {
+        end = fileLength - offset < length ? fileLength : offset + length;
+    }
+
+    std::vector<char> buffer((size_t) std::min((uint64_t) READ_SIZE, end - offset));
+    uint32_t partial = crc32cInit();
+    uint64_t position = offset;
+    while (position < end) {
+        uint64_t dataStart = position;
+        uint64_t dataEnd;
+        if (!nextDataExtent(fd, &dataStart, &dataEnd, end)) return false;
+        // The hole reads as zeros
+        if (dataStart > position) {
+            partial = crc32cShift(partial, crc32cShiftOperator(dataStart - position));
+        }
+        // The file was truncated to dataStart while it was read
+        if (dataStart == dataEnd && dataEnd < end) {
+            position = dataStart;
+            break;
+        }
+        int64_t bytes = crcData(fd, dataStart, dataEnd - dataStart, &buffer[0], &partial);
+        if (bytes < 0) return false;
+        position = dataStart + bytes;
+        // The file was truncated while it was read
+        if ((uint64_t) bytes < dataEnd - dataStart) break;
+    }
+
+    *crc = crc32cFinish(partial);
+    if (checksummedLength != NULL) *checksummedLength = position - offset;
+    return true;
+}
+
+bool crc32cFile(int fd, uint32_t* crc) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    if (S_ISREG(st.st_mode)) {
+        return crc32cFileRange(fd, 0, UINT64_MAX, crc);
+    }
+
+    std::vector<char> buffer(READ_SIZE);
+    uint32_t partial = crc32cInit();
+    while (true) {
+        ssize_t bytes = read(fd, &buffer[0], buffer.size());
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (bytes == 0) break;
+        partial = crc32c(partial, &buffer[0], bytes);
+    }
+    *crc = crc32cFinish(partial);
+    return true;
+}
+
+}  // namespace logging
@@ -0,0 +1,32 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_FILE_H__
+#define LOGGING_CRC32C_FILE_H__
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace logging {
+
+// Checksums files without reading their holes. The data extents of a sparse file are found with
+// lseek(SEEK_DATA) and lseek(SEEK_HOLE); each hole is added to the CRC by multiplying by
+// x^(8 * length) mod P(x), which costs O(log length). The result is identical to reading every
+// byte. Where the file system or platform cannot report holes, the whole range is read.
+//
+// These functions return false and set errno on error. They move the file offset of fd.
+
+// Computes the finished CRC32C of the file, or of everything readable from fd if it is not a
+// regular file (a pipe, for example).
+bool crc32cFile(int fd, uint32_t* crc);
+
+// Computes the finished CRC32C of the bytes in [offset, offset + length) of the regular file fd,
+// stopping at the end of the file. If checksummedLength is not NULL, it receives the length that
+// was checksummed: length clipped to the end of the file.
+bool crc32cFileRange(int fd, uint64_t offset, uint64_t length, uint32_t* crc,
+        uint64_t* checksummedLength = NULL);
+
+}  // namespace logging
+
+#endif
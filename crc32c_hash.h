@@ -0,0 +1,129 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_HASH_H__
+#define LOGGING_CRC32C_HASH_H__
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "crc32c.h"
+#include "crc32c_word.h"
+
+namespace logging {
+
+// A fast 64-bit hash function for hash tables, built on the CRC32 instruction.
+//
+// A raw CRC32C is a poor hash: it is linear, so flipping an input bit always flips the same output
+// bits, and 32 bits is too short for very large tables. This runs two independent CRC lanes with
+// different seeds (the second lane sees each word multiplied by an odd constant, so the lanes are
+// not affine copies of each other), then mixes the 64-bit concatenation with the MurmurHash3
+// finalizer. The lanes have no data dependency on each other, so they run in parallel.
+//
+// This is NOT a cryptographic hash and does not protect against hash flooding.
+//
+// Usage: std::unordered_map<uint64_t, Value, logging::Crc32cHash<uint64_t> > map;
+
+// Lane seeds: the first 32 bits of the fractional parts of sqrt(2) and sqrt(3).
+static const uint32_t CRC32C_HASH_SEED_A = 0x6a09e667;
+static const uint32_t CRC32C_HASH_SEED_B = 0xbb67ae85;
+// 2^64 / golden ratio: odd, with well distributed bits.
+static const uint64_t CRC32C_HASH_MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+
+// Combines the two lanes and the length, then applies the MurmurHash3 fmix64 finalizer so every
+// input bit affects every output bit.
+static inline uint64_t crc32cHashFinalize(uint32_t a, uint32_t b, uint64_t length) {
+    uint64_t h = (((uint64_t) a << 32) | b) ^ (length * CRC32C_HASH_MULTIPLIER);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Returns a 64-bit hash of length bytes at data.
+static inline uint64_t crc32cHash64(const void* data, size_t length, uint64_t seed = 0) {
+    const char* p_buf = (const char*) data;
+    uint32_t a = CRC32C_HASH_SEED_A ^ (uint32_t) seed;
+    uint32_t b = CRC32C_HASH_SEED_B ^ (uint32_t) (seed >> 32);
+
+    size_t words = length / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t word;
+        memcpy(&word, p_buf, sizeof(word));
+        a = crc32cWord(a, word);
+        b = crc32cWord(b, word * CRC32C_HASH_MULTIPLIER);
+        p_buf += sizeof(uint64_t);
+    }
+
+    // Pack the tail into one last word with at most two loads, instead of a variable length
+    // memcpy. Keys that only differ by trailing zeros are distinguished by mixing the length
+    // into the finalizer.
+    size_t remaining = length & (sizeof(uint64_t) - 1);
+    if (remaining > 0) {
+        uint64_t word;
+        if (remaining >= sizeof(uint32_t)) {
+            // Two overlapping 4 byte loads: the overlap lands on the same bit positions
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, p_buf, sizeof(low));
+            memcpy(&high, p_buf + remaining - sizeof(high), sizeof(high));
+            word = low | ((uint64_t) high << ((remaining - sizeof(high)) * 8));
+        } else {
+            word = (uint8_t) p_buf[0] | ((uint64_t) (uint8_t) p_buf[remaining / 2] << 8) |
+                    ((uint64_t) (uint8_t) p_buf[remaining - 1] << 16);
+        }
+        a = crc32cWord(a, word);
+        b = crc32cWord(b, word * CRC32C_HASH_MULTIPLIER);
+    }
+
+    return crc32cHashFinalize(a, b, length);
+}
+
+// Returns a 64-bit hash of a single integer. Equivalent to hashing it as one 8 byte word, but
+// without the loop or the tail handling.
+static inline uint64_t crc32cHashInteger(uint64_t value, uint64_t seed = 0) {
+    uint32_t a = crc32cWord(CRC32C_HASH_SEED_A ^ (uint32_t) seed, value);
+    uint32_t b = crc32cWord(CRC32C_HASH_SEED_B ^ (uint32_t) (seed >> 32),
+            value * CRC32C_HASH_MULTIPLIER);
+    return crc32cHashFinalize(a, b, sizeof(uint64_t));
+}
+
+// Hash functor for std::unordered_map and friends. Specialized for integral and enum keys,
+// std::string and std::string_view.
+template <typename Key, typename Enable = void>
+struct Crc32cHash;
+
+template <typename Key>
+struct Crc32cHash<Key, typename std::enable_if<
+        std::is_integral<Key>::value || std::is_enum<Key>::value>::type> {
+    size_t operator()(Key key) const {
+        return (size_t) crc32cHashInteger(static_cast<uint64_t>(key));
+    }
+};
+
+template <>
+struct Crc32cHash<std::string> {
+    size_t operator()(const std::string& key) const {
+        return (size_t) crc32cHash64(key.data(), key.size());
+    }
+};
+
+#if __cplusplus >= 201703L
+template <>
+struct Crc32cHash<std::string_view> {
+    size_t operator()(std::string_view key) const {
+        return (size_t) crc32cHash64(key.data(), key.size());
+    }
+};
+#endif
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,122 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_HASHER_H__
+#define LOGGING_CRC32C_HASHER_H__
+
+#include <cstring>
+
+#include "crc32c.h"
+#include "crc32c_word.h"
+
+namespace logging {
+
+// Computes a CRC32C incrementally from many small pieces, such as the fields of a record as it is
+// serialized. Calling crc32c() for each field pays an indirect call and the tail switch of the
+// kernel every time. Instead, update() is inline and collects bytes in a 64-bit register until a
+// whole word is available, which is fed to crc32cWord() directly. Large pieces are
+// passed to crc32c().
+//
+// Usage:
+//   Crc32cHasher hasher;
+//   hasher.update(&header, sizeof(header));
+//   hasher.update(name.data(), name.size());
+//   uint32_t crc = hasher.finish();
+class Crc32cHasher {
+public:
+    // Starts a CRC after the bytes whose unfinished CRC is crc.
+    explicit Crc32cHasher(uint32_t crc = crc32cInit()) : crc_(crc), pending_(0), numPending_(0) {}
+
+    void update(const void* data, size_t length) {
+        const char* p_buf = (const char*) data;
+        if (length <= sizeof(uint64_t) - numPending_) {
+            if (length == 0) return;
+            pending_ |= load(p_buf, length) << (8 * numPending_);
+            numPending_ += length;
+            if (numPending_ == sizeof(uint64_t)) {
+                crc_ = crc32cWord(crc_, pending_);
+                pending_ = 0;
+                numPending_ = 0;
+            }
+            return;
+        }
+        updateLong(p_buf, length);
+    }
+
+    // Returns the unfinished CRC of the bytes so far. Updates may continue afterwards.
+    uint32_t value() const {
+        uint32_t crc = crc_;
+        uint64_t pending = pending_;
+        for (size_t i = 0; i < numPending_; ++i) {
+            crc = crc32cByte(crc, (uint8_t) pending);
+            pending >>= 8;
+        }
+        return crc;
+    }
+
+    // Returns the finished CRC of the bytes so far. Updates may continue afterwards.
+    uint32_t finish() const { return crc32cFinish(value()); }
+
+    void reset(uint32_t crc = crc32cInit()) {
+        crc_ = crc;
+        pending_ = 0;
+        numPending_ = 0;
+    }
+
+private:
+    // Pieces longer than this are passed to crc32c(): the call is worth it
+    static const size_t LONG_LENGTH = 256;
+
+    // Returns 1 to 8 bytes at data as a little endian word, with at most 3 loads instead of a
+    // variable length memcpy.
+    static uint64_t load(const char* data, size_t length) {
+        if (length >= 4) {
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, data, sizeof(low));
+            memcpy(&high, data + length - 4, sizeof(high));
+            // The loads overlap when length < 8: the shared bytes are equal
+            return low | ((uint64_t) high << (8 * (length - 4)));
+        }
+        return (uint64_t) (uint8_t) data[0] |
+                (uint64_t) (uint8_t) data[length / 2] << (8 * (length / 2)) |
+                (uint64_t) (uint8_t) data[length - 1] << (8 * (length - 1));
+    }
+
+    void updateLong(const char* p_buf, size_t length) {
+        // Complete the pending word
+        if (numPending_ > 0) {
+            size_t fill = sizeof(uint64_t) - numPending_;
+            crc_ = crc32cWord(crc_, pending_ | load(p_buf, fill) << (8 * numPending_));
+            p_buf += fill;
+            length -= fill;
+        }
+
+        size_t remaining = length & (sizeof(uint64_t) - 1);
+        length -= remaining;
+        if (length > LONG_LENGTH) {
+            crc_ = crc32c(crc_, p_buf, length);
+            p_buf += length;
+        } else {
+            for (; length > 0; length -= sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, p_buf, sizeof(word));
+                crc_ = crc32cWord(crc_, word);
+                p_buf += sizeof(uint64_t);
+            }
+        }
+
+        pending_ = remaining > 0 ? load(p_buf, remaining) : 0;
+        numPending_ = remaining;
+    }
+
+    uint32_t crc_;
+    // The bytes not yet added to crc_, in little endian order
+    uint64_t pending_;
+    size_t numPending_;
+};
+
+}  // namespace logging
+
+#endif
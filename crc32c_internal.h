@@ -0,0 +1,81 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_INTERNAL_H__
+#define LOGGING_CRC32C_INTERNAL_H__
+
+// Helpers shared by the implementation files of the file formats: little endian integers,
+// one-shot CRCs, and reads and writes that retry after short transfers. Not part of the API.
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "crc32c.h"
+
+namespace logging {
+
+static inline void putU32(char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = (char) (value >> (8 * i));
+    }
+}
+
+static inline void putU64(char* p, uint64_t value) {
+    putU32(p, (uint32_t) value);
+    putU32(p + 4, (uint32_t) (value >> 32));
+}
+
+static inline uint32_t getU32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= (uint32_t) (uint8_t) p[i] << (8 * i);
+    }
+    return value;
+}
+
+static inline uint64_t getU64(const char* p) {
+    return getU32(p) | ((uint64_t) getU32(p + 4) << 32);
+}
+
+// Returns the finished CRC of length bytes at data.
+static inline uint32_t oneshot(const void* data, size_t length) {
+    return crc32cFinish(crc32c(crc32cInit(), data, length));
+}
+
+// Reads up to length bytes at offset, retrying short reads. Returns the number of bytes read,
+// which is less than length only at the end of the file, or -1 on error.
+static inline ssize_t preadFully(int fd, char* buffer, size_t length, uint64_t offset) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t bytes = pread(fd, buffer + total, length - total, (off_t) (offset + total));
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (bytes == 0) break;
+        total += bytes;
+    }
+    return total;
+}
+
+// Writes length bytes, retrying short writes. Returns false and sets errno on error.
+static inline bool writeFully(int fd, const char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t bytes = ::write(fd, buffer, length);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buffer += bytes;
+        length -= bytes;
+    }
+    return true;
+}
+
+}  // namespace logging
+
+#endif
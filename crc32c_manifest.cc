@@ -0,0 +1,128 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_manifest.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "crc32c.h"
+
+namespace logging {
+
+const size_t Crc32cManifest::OP_CACHE_SIZE;
+
+Crc32cManifest::Crc32cManifest() :
+        objectLength_(0), objectCrc_(0), hasRecorded_(false), recordedLength_(0),
+        recordedCrc_(0), errorLine_(0) {
+    uint32_t op = crc32cShiftOperator(0);
+    for (size_t i = 0; i < OP_CACHE_SIZE; ++i) {
+        cachedLengths_[i] = 0;
+        cachedOps_[i] = op;
+    }
+}
+
+void Crc32cManifest::add(uint64_t length, uint32_t crc) {
+    Shard shard = { length, crc };
+    shards_.push_back(shard);
+    // Computing an operator costs O(log length) multiplications, applying one costs one
+    size_t slot = (size_t) ((length ^ (length >> 12) ^ (length >> 24)) % OP_CACHE_SIZE);
+    if (cachedLengths_[slot] != length) {
+        cachedLengths_[slot] = length;
+        cachedOps_[slot] = crc32cShiftOperator((size_t) length);
+    }
+    objectCrc_ = crc32cShift(objectCrc_, cachedOps_[slot]) ^ crc;
+    objectLength_ += length;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parses an unsigned integer in base at *p, and advances *p past it and the spaces after it.
+static bool parseNumber(const char** p, const char* end, int base, uint64_t max,
+        uint64_t* value) {
+    const char* start = *p;
+    uint64_t result = 0;
+    for (; *p < end; ++*p) {
+        char c = **p;
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            break;
+        }
+        if (result > (max - digit) / base) return false;
+        result = result * base + digit;
+    }
+    if (*p == start) return false;
+    if (*p < end && !isSpace(**p)) return false;
+    while (*p < end && isSpace(**p)) ++*p;
+    *value = result;
+    return true;
+}
+
+bool Crc32cManifest::parse(const char* text, size_t length) {
+    *this = Crc32cManifest();
+    const char* end = text + length;
+    size_t line = 0;
+    for (const char* p = text; p < end; ) {
+        line += 1;
+        const char* lineEnd = (const char*) memchr(p, '\n', end - p);
+        if (lineEnd == NULL) lineEnd = end;
+        while (p < lineEnd && isSpace(*p)) ++p;
+
+        if (p < lineEnd && *p != '#') {
+            bool total = lineEnd - p > 5 && memcmp(p, "total", 5) == 0 && isSpace(p[5]);
+            if (total) p += 5;
+            while (p < lineEnd && isSpace(*p)) ++p;
+            uint64_t shardLength;
+            uint64_t crc;
+            if (!parseNumber(&p, lineEnd, 10, UINT64_MAX, &shardLength) ||
+                    !parseNumber(&p, lineEnd, 16, UINT32_MAX, &crc) || p != lineEnd ||
+                    (total && hasRecorded_)) {
+                errorLine_ = line;
+                errno = EINVAL;
+                return false;
+            }
+            if (total) {
+                hasRecorded_ = true;
+                recordedLength_ = shardLength;
+                recordedCrc_ = (uint32_t) crc;
+            } else {
+                add(shardLength, (uint32_t) crc);
+            }
+        }
+        p = lineEnd + 1;
+    }
+    return true;
+}
+
+bool Crc32cManifest::read(int fd) {
+    std::string text;
+    char buffer[1 << 16];
+    while (true) {
+        ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (bytes == 0) break;
+        text.append(buffer, bytes);
+    }
+    return parse(text.data(), text.size());
+}
+
+bool Crc32cManifest::consistent() const {
+    if (!hasRecorded_) return true;
+    return recordedLength_ == objectLength_ && recordedCrc_ == objectCrc_;
+}
+
+}  // namespace logging
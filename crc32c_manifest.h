@@ -0,0 +1,82 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_MANIFEST_H__
+#define LOGGING_CRC32C_MANIFEST_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+// The shards of an object stored in pieces, with the length and finished CRC32C of each. The
+// CRC of the whole object is derived with combine math, without reading any shard data.
+//
+// Text format, one entry per line:
+//
+//   LENGTH CRC          a shard: decimal length, hexadecimal finished CRC32C
+//   total LENGTH CRC    optional: the recorded length and CRC of the whole object
+//
+// Blank lines and lines starting with '#' are ignored. This is not crc32c-tee's output: its
+// checkpoint lines hold an offset and the CRC of the whole prefix, not a shard, so they cannot
+// be merged. Only its final total line has the same meaning.
+class Crc32cManifest {
+public:
+    Crc32cManifest();
+
+    // Appends a shard with length bytes and finished CRC crc.
+    void add(uint64_t length, uint32_t crc);
+
+    // Replaces the manifest with the one in text. Returns false with errno EINVAL if a line is
+    // malformed; errorLine() is then its line number, starting from 1.
+    bool parse(const char* text, size_t length);
+
+    // Reads and parses the manifest from fd until the end of the file. Returns false and sets
+    // errno on an I/O error or a malformed manifest.
+    bool read(int fd);
+
+    size_t numShards() const { return shards_.size(); }
+    uint64_t shardLength(size_t shard) const { return shards_[shard].length; }
+    uint32_t shardCrc(size_t shard) const { return shards_[shard].crc; }
+
+    // Returns the total length and finished CRC of the concatenated shards.
+    uint64_t objectLength() const { return objectLength_; }
+    uint32_t objectCrc() const { return objectCrc_; }
+
+    // Returns true if the manifest has a total line.
+    bool hasRecorded() const { return hasRecorded_; }
+    uint64_t recordedLength() const { return recordedLength_; }
+    uint32_t recordedCrc() const { return recordedCrc_; }
+
+    // Returns true if the shards match the recorded total, or if there is none.
+    bool consistent() const;
+
+    // Returns the line number of the error from the last failed parse().
+    size_t errorLine() const { return errorLine_; }
+
+private:
+    struct Shard {
+        uint64_t length;
+        uint32_t crc;
+    };
+
+    std::vector<Shard> shards_;
+    uint64_t objectLength_;
+    uint32_t objectCrc_;
+    // Shift operators of recently added shard lengths, direct mapped by length. Shards usually
+    // have a few distinct lengths, so most are combined with a single multiplication.
+    static const size_t OP_CACHE_SIZE = 64;
+    uint64_t cachedLengths_[OP_CACHE_SIZE];
+    uint32_t cachedOps_[OP_CACHE_SIZE];
+    bool hasRecorded_;
+    uint64_t recordedLength_;
+    uint32_t recordedCrc_;
+    size_t errorLine_;
+};
+
+}  // namespace logging
+
+#endif
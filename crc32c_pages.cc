@@ -0,0 +1,56 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_pages.h"
+
+#include <thread>
+
+#include "crc32c.h"
+
+namespace logging {
+
+std::vector<size_t> crc32cCorruptPages(const void* base, size_t pageSize, size_t count,
+        const uint32_t* expected, uint8_t* mismatchBitmap, int threads) {
+    std::vector<uint8_t> localBitmap;
+    if (mismatchBitmap == NULL) {
+        localBitmap.resize((count + 7) / 8);
+        mismatchBitmap = localBitmap.data();
+    }
+
+    // Ranges are whole bitmap bytes, so threads never write the same byte
+    size_t maxThreads = pageSize == 0 ? 1 : count * pageSize / CRC32C_PAGES_PER_THREAD_BYTES;
+    size_t numThreads = threads < 1 ? 1 : (size_t) threads;
+    if (numThreads > maxThreads) numThreads = maxThreads > 0 ? maxThreads : 1;
+    size_t rangeSize = ((count + numThreads - 1) / numThreads + 7) & ~(size_t) 7;
+
+    // Resolve the crc32c() kernel on this thread: the first call replaces the function pointer
+    crc32c(crc32cInit(), NULL, 0);
+
+    const char* p_buf = (const char*) base;
+    std::vector<std::thread> workers;
+    for (size_t start = rangeSize; start < count; start += rangeSize) {
+        size_t length = count - start < rangeSize ? count - start : rangeSize;
+        workers.push_back(std::thread(crc32cVerifyPages, p_buf + start * pageSize, pageSize,
+                length, expected + start, mismatchBitmap + start / 8));
+    }
+    size_t mismatches = crc32cVerifyPages(p_buf, pageSize, count < rangeSize ? count : rangeSize,
+            expected, mismatchBitmap);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    std::vector<size_t> corrupt;
+    if (mismatches == 0 && workers.empty()) return corrupt;
+
+    // Corruption is rare: skip clean bytes of the bitmap
+    for (size_t page = 0; page < count; ++page) {
+        if (page % 8 == 0 && mismatchBitmap[page / 8] == 0) {
+            page += 7;
+            continue;
+        }
+        if (mismatchBitmap[page / 8] & (1 << (page % 8))) corrupt.push_back(page);
+    }
+    return corrupt;
+}
+
+}  // namespace logging
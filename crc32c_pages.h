@@ -0,0 +1,28 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_PAGES_H__
+#define LOGGING_CRC32C_PAGES_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace logging {
+
+// The least data worth a thread of crc32cCorruptPages().
+static const size_t CRC32C_PAGES_PER_THREAD_BYTES = 1 << 20;
+
+// Verifies count contiguous pages of pageSize bytes at base against the finished CRC32C of each
+// page in expected, for example after recovery, and returns the indexes of the pages that do not
+// match in increasing order. Each thread runs crc32cVerifyPages() on a range of pages, with
+// interleaved CRC chains; threads are only started for ranges of at least
+// CRC32C_PAGES_PER_THREAD_BYTES. If mismatchBitmap is not NULL, it receives the bitmap from
+// crc32cVerifyPages().
+std::vector<size_t> crc32cCorruptPages(const void* base, size_t pageSize, size_t count,
+        const uint32_t* expected, uint8_t* mismatchBitmap = 0, int threads = 1);
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_prefix_index.h"
+
+#include <cassert>
+#include <thread>
+
+#include "crc32c.h"
+
+namespace logging {
+
+// Stores the finished CRC of each block in [first, last) in crcs.
+static void computeBlockCrcs(const char* data, size_t blockSize, size_t first, size_t last,
+        uint32_t* crcs) {
+    for (size_t i = first; i < last; ++i) {
+        crcs[i] = crc32cFinish(crc32c(crc32cInit(), data + i * blockSize, blockSize));
+    }
+}
+
+Crc32cPrefixIndex::Crc32cPrefixIndex(const void* data, size_t length, size_t blockSize,
+        int threads) :
+        data_((const char*) data), length_(length), blockSize_(blockSize), crc_(0),
+        prefixes_(length / blockSize + 1) {
+    assert(blockSize_ > 0);
+    size_t blocks = length_ / blockSize_;
+
+    // Compute each block's CRC into prefixes_[i + 1]. Blocks are independent, so split them into
+    // contiguous ranges, one per thread.
+    uint32_t* blockCrcs = prefixes_.data() + 1;
+    size_t numThreads = threads < 1 ? 1 : (size_t) threads;
+    if (numThreads > blocks) numThreads = blocks > 0 ? blocks : 1;
+
+    // Resolve the crc32c() kernel on this thread: the first call replaces the function pointer
+    crc32c(crc32cInit(), NULL, 0);
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < numThreads; ++t) {
+        workers.push_back(std::thread(computeBlockCrcs, data_, blockSize_,
+                blocks * t / numThreads, blocks * (t + 1) / numThreads, blockCrcs));
+    }
+    computeBlockCrcs(data_, blockSize_, 0, blocks / numThreads, blockCrcs);
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    // Chain them: every block has the same length, so the shift operator is computed once
+    uint32_t op = crc32cShiftOperator(blockSize_);
+    prefixes_[0] = 0;
+    for (size_t i = 1; i <= blocks; ++i) {
+        prefixes_[i] = crc32cShift(prefixes_[i - 1], op) ^ prefixes_[i];
+    }
+
+    crc_ = prefixCrc(length_);
+}
+
+uint32_t Crc32cPrefixIndex::prefixCrc(size_t end) const {
+    size_t block = end / blockSize_;
+    size_t start = block * blockSize_;
+    // crc32cFinish is its own inverse: this continues the CRC from the stored prefix
+    uint32_t crc = crc32cFinish(prefixes_[block]);
+    return crc32cFinish(crc32c(crc, data_ + start, end - start));
+}
+
+uint32_t Crc32cPrefixIndex::rangeCrc(size_t offset, size_t length) const {
+    assert(offset <= length_ && length <= length_ - offset);
+    size_t end = offset + length;
+    size_t lastBoundary = end / blockSize_ * blockSize_;
+    if (lastBoundary <= offset) {
+        // The range does not cross a block boundary: it is shorter than a block, so scan it
+        return crc32cFinish(crc32c(crc32cInit(), data_ + offset, length));
+    }
+
+    // data[offset, lastBoundary) is what remains after removing data[0, offset) from the prefix
+    // that ends on lastBoundary
+    uint32_t crc = crc32cRemovePrefix(prefixes_[end / blockSize_], prefixCrc(offset),
+            lastBoundary - offset);
+    return crc32cFinish(crc32c(crc32cFinish(crc), data_ + lastBoundary, end - lastBoundary));
+}
+
+}  // namespace logging
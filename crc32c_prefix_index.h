@@ -0,0 +1,49 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_PREFIX_INDEX_H__
+#define LOGGING_CRC32C_PREFIX_INDEX_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace logging {
+
+// Answers CRC32C queries for any byte range of a large immutable buffer without rescanning it.
+//
+// The index stores the CRC of every prefix that ends on a block boundary. The CRC of a range
+// comes from the prefix CRC of the block containing its start, a scan up to the start, one shift
+// to remove that prefix, and a scan of the partial block at the end: at most two blocks of data
+// are read. The index uses 4 bytes per block, so blockSize trades memory for query cost.
+class Crc32cPrefixIndex {
+public:
+    // Indexes length bytes at data. The data is not copied, so it must remain valid and
+    // unchanged for the lifetime of the index. The block CRCs are computed with threads threads.
+    Crc32cPrefixIndex(const void* data, size_t length, size_t blockSize, int threads = 1);
+
+    size_t length() const { return length_; }
+    size_t blockSize() const { return blockSize_; }
+
+    // Returns the finished CRC of the whole buffer.
+    uint32_t crc() const { return crc_; }
+
+    // Returns the finished CRC of data[offset, offset + length). The range must be in the buffer.
+    uint32_t rangeCrc(size_t offset, size_t length) const;
+
+private:
+    // Returns the finished CRC of data[0, end).
+    uint32_t prefixCrc(size_t end) const;
+
+    const char* data_;
+    size_t length_;
+    size_t blockSize_;
+    uint32_t crc_;
+    // prefixes_[i] is the finished CRC of data[0, i * blockSize_).
+    std::vector<uint32_t> prefixes_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,125 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_record_log.h"
+
+#include "crc32c.h"
+#include "crc32c_internal.h"
+
+namespace logging {
+
+const size_t Crc32cRecordReader::HEADER_SIZE;
+const size_t Crc32cRecordReader::DEFAULT_MAX_RECORD_LENGTH;
+const size_t Crc32cRecordReader::BATCH;
+
+Crc32cRecordReader::Crc32cRecordReader(const void* data, size_t length, bool complete,
+        size_t maxRecordLength) :
+        data_((const char*) data), length_(length), complete_(complete),
+        maxRecordLength_(maxRecordLength), offset_(0), skippedBytes_(0), numCorruptions_(0) {
+}
+
+Crc32cRecordReader::HeaderStatus Crc32cRecordReader::parseHeader(size_t offset,
+        size_t* length) const {
+    size_t remaining = length_ - offset;
+    if (remaining < HEADER_SIZE) {
+        return complete_ ? CORRUPT : INCOMPLETE;
+    }
+    *length = getU32(data_ + offset);
+    if (*length > maxRecordLength_) return CORRUPT;
+    if (*length > remaining - HEADER_SIZE) {
+        return complete_ ? CORRUPT : INCOMPLETE;
+    }
+    return VALID;
+}
+
+bool Crc32cRecordReader::followedByHeader(size_t offset, size_t length) const {
+    size_t next = offset + HEADER_SIZE + length;
+    // A torn write can leave a short or truncated record at the end: only check the length limit
+    if (length_ - next < HEADER_SIZE) return true;
+    return getU32(data_ + next) <= maxRecordLength_;
+}
+
+void Crc32cRecordReader::resync() {
+    numCorruptions_ += 1;
+    size_t start = offset_;
+    for (offset_ = start + 1; offset_ < length_; ++offset_) {
+        size_t length;
+        HeaderStatus status = parseHeader(offset_, &length);
+        // Not enough data to tell if this is a record: stop and wait for more
+        if (status == INCOMPLETE) break;
+        // Checking the next header first avoids checksumming a payload at most offsets
+        if (status == VALID && followedByHeader(offset_, length)) {
+            const char* payload = data_ + offset_ + HEADER_SIZE;
+            uint32_t crc = oneshot(payload, length);
+            if (crc32cMask(crc) == getU32(data_ + offset_ + 4)) break;
+        }
+    }
+    skippedBytes_ += offset_ - start;
+}
+
+size_t Crc32cRecordReader::read(std::vector<Crc32cRecord>* records, size_t maxRecords) {
+    size_t numRecords = 0;
+    while (numRecords < maxRecords && offset_ < length_) {
+        // Parse a batch of headers: the lengths give the payload locations before any CRC is
+        // checked, so the payloads can be checksummed together
+        const void* payloads[BATCH];
+        size_t lengths[BATCH];
+        size_t offsets[BATCH];
+        uint32_t crcs[BATCH];
+        size_t batchSize = 0;
+        size_t next = offset_;
+        HeaderStatus status = VALID;
+        while (batchSize < BATCH && numRecords + batchSize < maxRecords && next < length_) {
+            size_t length;
+            status = parseHeader(next, &length);
+            if (status != VALID) break;
+            offsets[batchSize] = next;
+            payloads[batchSize] = data_ + next + HEADER_SIZE;
+            lengths[batchSize] = length;
+            batchSize += 1;
+            next += HEADER_SIZE + length;
+        }
+        crc32cBatch(payloads, lengths, crcs, batchSize);
+
+        for (size_t i = 0; i < batchSize; ++i) {
+            if (crc32cMask(crcs[i]) != getU32(data_ + offsets[i] + 4)) {
+                // The records after this one were parsed using a length that may be corrupt
+                offset_ = offsets[i];
+                status = CORRUPT;
+                break;
+            }
+            Crc32cRecord record;
+            record.offset = offsets[i];
+            record.data = (const char*) payloads[i];
+            record.length = lengths[i];
+            records->push_back(record);
+            numRecords += 1;
+            offset_ = offsets[i] + HEADER_SIZE + lengths[i];
+        }
+
+        if (status == CORRUPT) {
+            resync();
+        } else if (status == INCOMPLETE) {
+            break;
+        }
+    }
+    return numRecords;
+}
+
+void Crc32cRecordWriter::append(const void* payload, size_t length) {
+    size_t start = out_->size();
+    out_->resize(start + Crc32cRecordReader::HEADER_SIZE + length);
+    char* header = &(*out_)[start];
+    uint32_t crc = crc32cCopy(crc32cInit(), header + Crc32cRecordReader::HEADER_SIZE, payload,
+            length);
+    putU32(header, (uint32_t) length);
+    putU32(header + 4, crc32cMask(crc32cFinish(crc)));
+}
+
+void Crc32cRecordWriter::encodeHeader(const void* payload, size_t length, char header[8]) {
+    putU32(header, (uint32_t) length);
+    putU32(header + 4, crc32cMask(oneshot(payload, length)));
+}
+
+}  // namespace logging
@@ -0,0 +1,111 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_RECORD_LOG_H__
+#define LOGGING_CRC32C_RECORD_LOG_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+// Log records framed as [length][masked crc][payload], in the style of LevelDB and RocksDB:
+//
+//   offset size
+//        0    4  payload length, little endian
+//        4    4  crc32cMask() of the finished CRC32C of the payload, little endian
+//        8       payload
+
+// A record read from a log: a view into the reader's input buffer.
+struct Crc32cRecord {
+    // Offset of the record's header in the input buffer.
+    size_t offset;
+    const char* data;
+    size_t length;
+};
+
+// Reads and verifies records from a buffer without copying them. Headers are parsed ahead and
+// the payloads of up to BATCH records are checksummed together with crc32cBatch.
+//
+// When a record is corrupt (its length is impossible or its CRC does not match), the reader
+// resynchronizes by searching forward one byte at a time for the next valid record. The skipped
+// bytes are counted in skippedBytes(). A candidate's payload is only checksummed if the header
+// after it has a possible length, so the search does not checksum up to maxRecordLength bytes at
+// every offset; a record followed by a corrupt length is skipped along with it.
+class Crc32cRecordReader {
+public:
+    static const size_t HEADER_SIZE = 8;
+    static const size_t DEFAULT_MAX_RECORD_LENGTH = 64 << 20;
+    // Number of records checksummed together.
+    static const size_t BATCH = 16;
+
+    // Reads length bytes at data, which must remain valid while the records are used. If
+    // complete is false, the buffer may end in the middle of a record: read() stops before a
+    // record that runs past the end, and consumed() is where to resume once more data arrives.
+    // Records longer than maxRecordLength are treated as corruption.
+    Crc32cRecordReader(const void* data, size_t length, bool complete = true,
+            size_t maxRecordLength = DEFAULT_MAX_RECORD_LENGTH);
+
+    // Appends up to maxRecords valid records to records. Returns the number appended, which is 0
+    // once the end of the buffer is reached.
+    size_t read(std::vector<Crc32cRecord>* records, size_t maxRecords = (size_t) -1);
+
+    // Returns the number of bytes that have been read or skipped.
+    size_t consumed() const { return offset_; }
+
+    // Returns the number of bytes skipped while resynchronizing, including an incomplete
+    // record at the end of a complete buffer.
+    uint64_t skippedBytes() const { return skippedBytes_; }
+
+    // Returns the number of times the reader resynchronized after a corrupt record.
+    size_t numCorruptions() const { return numCorruptions_; }
+
+private:
+    enum HeaderStatus {
+        VALID,
+        CORRUPT,
+        // The record runs past the end of an incomplete buffer
+        INCOMPLETE
+    };
+
+    // Checks that the header at offset has a possible length, and sets *length.
+    HeaderStatus parseHeader(size_t offset, size_t* length) const;
+
+    // Returns true if the record of length bytes at offset is followed by the end of the data or
+    // by a header with a length up to maxRecordLength_.
+    bool followedByHeader(size_t offset, size_t length) const;
+
+    // Skips past a corrupt record at offset_, to the next offset with a valid record.
+    void resync();
+
+    const char* data_;
+    size_t length_;
+    bool complete_;
+    size_t maxRecordLength_;
+    size_t offset_;
+    uint64_t skippedBytes_;
+    size_t numCorruptions_;
+};
+
+// Appends records to a buffer, computing each payload's CRC while it is copied.
+class Crc32cRecordWriter {
+public:
+    // Records are appended to out, which must outlive the writer.
+    explicit Crc32cRecordWriter(std::string* out) : out_(out) {}
+
+    void append(const void* payload, size_t length);
+
+    // Writes the header for length bytes at payload, which will be written separately. Useful
+    // when the payload is already in an output buffer or is written with writev.
+    static void encodeHeader(const void* payload, size_t length, char header[8]);
+
+private:
+    std::string* out_;
+};
+
+}  // namespace logging
+
+#endif
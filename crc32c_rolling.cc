@@ -0,0 +1,223 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_rolling.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace logging {
+
+// Number of independent chains used by rollBuffer.
+static const size_t LANES = 4;
+// Minimum number of windows per chain. Each chain must compute its first window from scratch.
+static const size_t MIN_LANE_WINDOWS = 256;
+// Number of windows searched per batch by find and findMasked. The chains keep rolling to the
+// end of the batch after a match, so this is the smallest batch that has four full chains.
+static const size_t FIND_BLOCK_WINDOWS = LANES * MIN_LANE_WINDOWS;
+
+static const char ZEROS[256] = {};
+
+const size_t RollingCrc32c::NOT_FOUND;
+
+// Returns the finished CRC of byte followed by zeros zero bytes.
+static uint32_t crcOfByteThenZeros(uint8_t byte, size_t zeros) {
+    uint32_t crc = crc32c(crc32cInit(), &byte, 1);
+    while (zeros > 0) {
+        size_t length = std::min(zeros, sizeof(ZEROS));
+        crc = crc32c(crc, ZEROS, length);
+        zeros -= length;
+    }
+    return crc32cFinish(crc);
+}
+
+RollingCrc32c::RollingCrc32c(size_t window) : window_(window) {
+    assert(window_ > 0);
+
+    // Appending a zero byte to the window [b, 0, ..., 0] must produce the CRC of the all zeros
+    // window: leaving_[b] is whatever is needed to make that true.
+    uint32_t allZeros = crcOfByteThenZeros(0, window_ - 1);
+    uint32_t leavingValues[9];
+    for (int bit = 0; bit < 9; ++bit) {
+        uint8_t byte = bit == 0 ? 0 : (uint8_t) (1 << (bit - 1));
+        uint32_t crc = crc32cSarwate(crcOfByteThenZeros(byte, window_ - 1), ZEROS, 1);
+        leavingValues[bit] = allZeros ^ crc;
+    }
+
+    // CRC is affine in the leaving byte: combine the values for each bit instead of computing
+    // all 256 entries over the full window.
+    for (int byte = 0; byte < 256; ++byte) {
+        uint32_t value = leavingValues[0];
+        for (int bit = 0; bit < 8; ++bit) {
+            if (byte & (1 << bit)) {
+                value ^= leavingValues[bit + 1] ^ leavingValues[0];
+            }
+        }
+        leaving_[byte] = value;
+    }
+}
+
+uint32_t RollingCrc32c::start(const void* data) const {
+    return crc32cFinish(crc32c(crc32cInit(), data, window_));
+}
+
+template <bool Hardware>
+inline uint32_t RollingCrc32c::rollWith(uint32_t crc, uint8_t out, uint8_t in) const {
+#if !((defined __ppc__) || (defined __ppc64__))
+    if (Hardware) return crc32cByteHardware(crc, in) ^ leaving_[out];
+#endif
+    return crc32cByteTable(crc, in) ^ leaving_[out];
+}
+
+template <bool Hardware>
+void RollingCrc32c::rollChain(const char* data, size_t count, uint32_t* crcs) const {
+    uint32_t crc = crcs[0];
+    for (size_t i = 1; i < count; ++i) {
+        crc = rollWith<Hardware>(crc, data[i - 1], data[i - 1 + window_]);
+        crcs[i] = crc;
+    }
+}
+
+void RollingCrc32c::rollBuffer(const void* data, size_t length, uint32_t* crcs) const {
+    if (length < window_) return;
+#if !((defined __ppc__) || (defined __ppc64__))
+    if (crc32cHasHardware()) {
+        rollLanes<true>((const char*) data, length, crcs);
+        return;
+    }
+#endif
+    rollLanes<false>((const char*) data, length, crcs);
+}
+
+template <bool Hardware>
+void RollingCrc32c::rollLanes(const char* p_buf, size_t length, uint32_t* crcs) const {
+    size_t count = length - window_ + 1;
+
+    size_t laneWindows = count / LANES;
+    if (laneWindows < MIN_LANE_WINDOWS || laneWindows < 4 * window_) {
+        crcs[0] = start(p_buf);
+        rollChain<Hardware>(p_buf, count, crcs);
+        return;
+    }
+
+    // Each roll depends on the previous one, which limits a single chain to the latency of the
+    // CRC32 instruction. Split the windows into independent chains and interleave them to keep
+    // several instructions in flight.
+    const char* p0 = p_buf;
+    const char* p1 = p_buf + laneWindows;
+    const char* p2 = p_buf + 2 * laneWindows;
+    const char* p3 = p_buf + 3 * laneWindows;
+    uint32_t* out0 = crcs;
+    uint32_t* out1 = crcs + laneWindows;
+    uint32_t* out2 = crcs + 2 * laneWindows;
+    uint32_t* out3 = crcs + 3 * laneWindows;
+    uint32_t crc0 = *out0 = start(p0);
+    uint32_t crc1 = *out1 = start(p1);
+    uint32_t crc2 = *out2 = start(p2);
+    uint32_t crc3 = *out3 = start(p3);
+    for (size_t i = 1; i < laneWindows; ++i) {
+        crc0 = rollWith<Hardware>(crc0, p0[i - 1], p0[i - 1 + window_]);
+        crc1 = rollWith<Hardware>(crc1, p1[i - 1], p1[i - 1 + window_]);
+        crc2 = rollWith<Hardware>(crc2, p2[i - 1], p2[i - 1 + window_]);
+        crc3 = rollWith<Hardware>(crc3, p3[i - 1], p3[i - 1 + window_]);
+        out0[i] = crc0;
+        out1[i] = crc1;
+        out2[i] = crc2;
+        out3[i] = crc3;
+    }
+
+    // The last chain also covers the windows left over by the division
+    size_t last = 4 * laneWindows - 1;
+    rollChain<Hardware>(p_buf + last, count - last, crcs + last);
+}
+
+size_t RollingCrc32c::find(const void* data, size_t length, uint32_t target) const {
+    return search((const char*) data, length, 0xFFFFFFFF, target);
+}
+
+size_t RollingCrc32c::findMasked(const void* data, size_t length, uint32_t mask) const {
+    return search((const char*) data, length, mask, 0);
+}
+
+size_t RollingCrc32c::search(const char* p_buf, size_t length, uint32_t mask,
+        uint32_t target) const {
+    if (length < window_) return NOT_FOUND;
+    size_t count = length - window_ + 1;
+#if !((defined __ppc__) || (defined __ppc64__))
+    bool hardware = crc32cHasHardware();
+#endif
+
+    // Batches must be large compared to the window, since each one starts from scratch, but
+    // small enough that the chains after a match do little wasted work
+    size_t blockWindows = std::max(FIND_BLOCK_WINDOWS, 8 * window_);
+    for (size_t offset = 0; offset < count; offset += blockWindows) {
+        size_t windows = std::min(blockWindows, count - offset);
+#if !((defined __ppc__) || (defined __ppc64__))
+        size_t found = hardware ? searchLanes<true>(p_buf + offset, windows, mask, target) :
+                searchLanes<false>(p_buf + offset, windows, mask, target);
+#else
+        size_t found = searchLanes<false>(p_buf + offset, windows, mask, target);
+#endif
+        if (found != NOT_FOUND) return offset + found;
+    }
+    return NOT_FOUND;
+}
+
+template <bool Hardware>
+size_t RollingCrc32c::searchLanes(const char* p_buf, size_t count, uint32_t mask,
+        uint32_t target) const {
+    size_t laneWindows = count / LANES;
+    if (laneWindows < MIN_LANE_WINDOWS || laneWindows < 4 * window_) {
+        uint32_t crc = start(p_buf);
+        for (size_t i = 0; ; ) {
+            if ((crc & mask) == target) return i;
+            if (++i == count) return NOT_FOUND;
+            crc = rollWith<Hardware>(crc, p_buf[i - 1], p_buf[i - 1 + window_]);
+        }
+    }
+
+    // As in rollBuffer, but each chain is tested as it rolls. Matches are rare, so the four
+    // tests share one branch. The first chain's match is the earliest; the others are kept
+    // until every chain before them has finished without one.
+    const char* p0 = p_buf;
+    const char* p1 = p_buf + laneWindows;
+    const char* p2 = p_buf + 2 * laneWindows;
+    const char* p3 = p_buf + 3 * laneWindows;
+    uint32_t crc0 = start(p0);
+    uint32_t crc1 = start(p1);
+    uint32_t crc2 = start(p2);
+    uint32_t crc3 = start(p3);
+    size_t found1 = NOT_FOUND;
+    size_t found2 = NOT_FOUND;
+    size_t found3 = NOT_FOUND;
+    for (size_t i = 0; ; ) {
+        bool match0 = (crc0 & mask) == target;
+        bool match1 = (crc1 & mask) == target;
+        bool match2 = (crc2 & mask) == target;
+        bool match3 = (crc3 & mask) == target;
+        if (match0 | match1 | match2 | match3) {
+            if (match0) return i;
+            if (match1 && found1 == NOT_FOUND) found1 = laneWindows + i;
+            if (match2 && found2 == NOT_FOUND) found2 = 2 * laneWindows + i;
+            if (match3 && found3 == NOT_FOUND) found3 = 3 * laneWindows + i;
+        }
+        if (++i == laneWindows) break;
+        crc0 = rollWith<Hardware>(crc0, p0[i - 1], p0[i - 1 + window_]);
+        crc1 = rollWith<Hardware>(crc1, p1[i - 1], p1[i - 1 + window_]);
+        crc2 = rollWith<Hardware>(crc2, p2[i - 1], p2[i - 1 + window_]);
+        crc3 = rollWith<Hardware>(crc3, p3[i - 1], p3[i - 1 + window_]);
+    }
+    if (found1 != NOT_FOUND) return found1;
+    if (found2 != NOT_FOUND) return found2;
+    if (found3 != NOT_FOUND) return found3;
+
+    // The last chain also covers the windows left over by the division
+    for (size_t i = 4 * laneWindows; i < count; ++i) {
+        crc3 = rollWith<Hardware>(crc3, p_buf[i - 1], p_buf[i - 1 + window_]);
+        if ((crc3 & mask) == target) return i;
+    }
+    return NOT_FOUND;
+}
+
+}  // namespace logging
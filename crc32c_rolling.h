@@ -0,0 +1,81 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_ROLLING_H__
+#define LOGGING_CRC32C_ROLLING_H__
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "crc32c.h"
+#include "crc32c_word.h"
+
+namespace logging {
+
+// Computes the CRC32C of a fixed size window as it slides over data, in O(1) per byte.
+//
+// CRC is linear, so the contribution of the byte leaving the window depends only on its value
+// and the window size. It is precomputed in a 256 entry "byte leaving" table, and removed with
+// one XOR when the window slides. All CRC values are finished values: the same as
+// crc32cFinish(crc32c(crc32cInit(), window, size)).
+class RollingCrc32c {
+public:
+    // Value returned by find() and findMasked() when there is no match.
+    static const size_t NOT_FOUND = (size_t) -1;
+
+    // window is the number of bytes in the window. It must be > 0.
+    explicit RollingCrc32c(size_t window);
+
+    size_t window() const { return window_; }
+
+    // Returns the CRC of the first window() bytes of data.
+    uint32_t start(const void* data) const;
+
+    // Slides the window by one byte: out leaves the window and in enters it. crc is the CRC of
+    // the current window; returns the CRC of the new window.
+    uint32_t roll(uint32_t crc, uint8_t out, uint8_t in) const {
+        return crc32cByte(crc, in) ^ leaving_[out];
+    }
+
+    // Writes the CRC of every window in data to crcs: crcs[i] is the CRC of data[i, i+window()).
+    // crcs must have room for length - window() + 1 values. Does nothing if length < window().
+    void rollBuffer(const void* data, size_t length, uint32_t* crcs) const;
+
+    // Returns the offset of the first window in data with CRC target, or NOT_FOUND.
+    size_t find(const void* data, size_t length, uint32_t target) const;
+
+    // Returns the offset of the first window in data whose CRC has every bit of mask clear, or
+    // NOT_FOUND: the boundary test of content-defined chunking. Like find(), the windows are
+    // rolled in interleaved chains and tested as they are computed, without storing the CRCs.
+    size_t findMasked(const void* data, size_t length, uint32_t mask) const;
+
+private:
+    // roll() with the CRC32 instruction or the table picked by the caller, once per buffer
+    // instead of once per byte.
+    template <bool Hardware>
+    uint32_t rollWith(uint32_t crc, uint8_t out, uint8_t in) const;
+
+    // Rolls a single chain from data[0] for count windows. crcs[0] must already be computed.
+    template <bool Hardware>
+    void rollChain(const char* data, size_t count, uint32_t* crcs) const;
+
+    // rollBuffer() for length >= window().
+    template <bool Hardware>
+    void rollLanes(const char* data, size_t length, uint32_t* crcs) const;
+
+    // Returns the first window with (crc & mask) == target, or NOT_FOUND.
+    size_t search(const char* data, size_t length, uint32_t mask, uint32_t target) const;
+
+    // search() over the count windows starting at data, which are all computed from scratch.
+    template <bool Hardware>
+    size_t searchLanes(const char* data, size_t count, uint32_t mask, uint32_t target) const;
+
+    size_t window_;
+    // leaving_[b] removes byte b from the front of the window as a new byte is appended.
+    uint32_t leaving_[256];
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,251 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_scrubber.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+#include "crc32c.h"
+#include "crc32c_file.h"
+#include "crc32c_sidecar.h"
+
+namespace logging {
+
+const size_t Crc32cScrubber::CHUNK_SIZE;
+
+// Pauses for a busy machine start at this length and double up to the maximum
+static const int MIN_PAUSE_MILLIS = 10;
+static const int MAX_PAUSE_MILLIS = 1000;
+
+static int64_t threadCpuNanos() {
+    struct timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0) return 0;
+    return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Puts the calling thread in the idle I/O scheduling class, where it only gets disk time when
+// no other process wants it.
+static void setIdleIoPriority() {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    static const int IOPRIO_WHO_PROCESS = 1;
+    static const int IOPRIO_CLASS_IDLE = 3;
+    static const int IOPRIO_CLASS_SHIFT = 13;
+    // Process 0 is the calling thread; failure only means normal priority
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+Crc32cScrubber::Crc32cScrubber(uint64_t bytesPerSecond, double cpuPercent) :
+        bytesPerSecond_(bytesPerSecond),
+        cpuFraction_(std::min(std::max(cpuPercent, 0.1), 100.0) / 100), lowPriorityIo_(true),
+        busy_(&Crc32cScrubber::isLoadHigh), tokens_(0), passStartCpuNanos_(0), stop_(false),
+        bytesVerified_(0), passBytesVerified_(0), passBytesTotal_(0), passes_(0),
+        mismatches_(0), staleSidecars_(0), errors_(0), pauses_(0) {
+}
+
+void Crc32cScrubber::addFile(const std::string& path, uint32_t crc) {
+    Target target = { path, false, crc };
+    targets_.push_back(target);
+}
+
+void Crc32cScrubber::addSidecarFile(const std::string& path) {
+    Target target = { path, true, 0 };
+    targets_.push_back(target);
+}
+
+bool Crc32cScrubber::isLoadHigh() {
+    double load;
+    if (getloadavg(&load, 1) != 1) return false;
+    unsigned cpus = std::thread::hardware_concurrency();
+    return load > (cpus == 0 ? 1 : cpus);
+}
+
+void Crc32cScrubber::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    stopped_.notify_all();
+}
+
+bool Crc32cScrubber::sleep(Clock::duration duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopped_.wait_for(lock, duration, [this]() { return stop_; });
+    return !stop_;
+}
+
+bool Crc32cScrubber::throttle(size_t length) {
+    int pauseMillis = MIN_PAUSE_MILLIS;
+    while (busy_ && busy_()) {
+        pauses_ += 1;
+        if (!sleep(std::chrono::milliseconds(pauseMillis))) return false;
+        pauseMillis = std::min(2 * pauseMillis, MAX_PAUSE_MILLIS);
+    }
+    if (bytesPerSecond_ == 0) return sleep(Clock::duration::zero());
+
+    // Refill, up to a burst of one chunk, then take the tokens. If that leaves a debt, sleep
+    // until it is repaid
+    Clock::time_point now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - lastRefill_).count();
+    lastRefill_ = now;
+    tokens_ = std::min(tokens_ + seconds * bytesPerSecond_, (double) CHUNK_SIZE);
+    tokens_ -= length;
+    if (tokens_ >= 0) return sleep(Clock::duration::zero());
+    std::chrono::duration<double> wait(-tokens_ / bytesPerSecond_);
+    return sleep(std::chrono::duration_cast<Clock::duration>(wait));
+}
+
+bool Crc32cScrubber::limitCpu() {
+    if (cpuFraction_ >= 1) return true;
+    double cpuSeconds = (threadCpuNanos() - passStartCpuNanos_) / 1e9;
+    double wallSeconds = std::chrono::duration<double>(Clock::now() - passStart_).count();
+    double excess = cpuSeconds / cpuFraction_ - wallSeconds;
+    if (excess <= 0) return true;
+    return sleep(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(excess)));
+}
+
+void Crc32cScrubber::reportMismatch(const std::string& path, uint64_t offset, uint64_t length) {
+    mismatches_ += 1;
+    if (mismatch_) mismatch_(path, offset, length);
+}
+
+bool Crc32cScrubber::scrubFile(const Target& target) {
+    int fd = open(target.path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        errors_ += 1;
+        return true;
+    }
+
+    uint32_t crc = 0;
+    uint64_t offset = 0;
+    bool success = true;
+    while (offset < (uint64_t) st.st_size) {
+        size_t length = (size_t) std::min((uint64_t) CHUNK_SIZE, st.st_size - offset);
+        if (!throttle(length)) {
+            close(fd);
+            return false;
+        }
+        uint32_t chunkCrc;
+        uint64_t bytes;
+        if (!crc32cFileRange(fd, offset, length, &chunkCrc, &bytes)) {
+            success = false;
+            break;
+        }
+        crc = crc32cCombine(crc, chunkCrc, (size_t) bytes);
+        offset += bytes;
+        bytesVerified_ += bytes;
+        passBytesVerified_ += bytes;
+        // Truncated since the stat: the CRC will not match
+        if (bytes < length) break;
+        if (!limitCpu()) {
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    if (!success) {
+        errors_ += 1;
+    } else if (crc != target.crc) {
+        reportMismatch(target.path, 0, offset);
+    }
+    return true;
+}
+
+bool Crc32cScrubber::scrubSidecar(const Target& target) {
+    Crc32cSidecar sidecar;
+    int fd = -1;
+    if (!sidecar.read(Crc32cSidecar::sidecarPath(target.path)) ||
+            (fd = open(target.path.c_str(), O_RDONLY)) < 0) {
+        errors_ += 1;
+        return true;
+    }
+    // The file was changed after the sidecar was written: its blocks would all be reported
+    if (!sidecar.matchesFile(fd)) {
+        close(fd);
+        staleSidecars_ += 1;
+        if (stale_) stale_(target.path);
+        return true;
+    }
+
+    // Verify one block at a time, so mismatches are reported per block. Blocks larger than a
+    // chunk are read and throttled a chunk at a time, and the chunk CRCs combined
+    bool success = true;
+    for (size_t block = 0; block < sidecar.numBlocks() && success; ++block) {
+        uint64_t blockOffset = sidecar.blockOffset(block);
+        uint64_t blockLength = sidecar.blockLength(block);
+        uint32_t crc = 0;
+        uint64_t done = 0;
+        while (done < blockLength) {
+            size_t length = (size_t) std::min((uint64_t) CHUNK_SIZE, blockLength - done);
+            if (!throttle(length)) {
+                close(fd);
+                return false;
+            }
+            uint32_t chunkCrc;
+            uint64_t bytes;
+            if (!crc32cFileRange(fd, blockOffset + done, length, &chunkCrc, &bytes)) {
+                success = false;
+                break;
+            }
+            crc = crc32cCombine(crc, chunkCrc, (size_t) bytes);
+            done += bytes;
+            bytesVerified_ += bytes;
+            passBytesVerified_ += bytes;
+            if (!limitCpu()) {
+                close(fd);
+                return false;
+            }
+            // Truncated since the sidecar was checked: the block does not match
+            if (bytes < length) break;
+        }
+        if (success && (done != blockLength || crc != sidecar.blockCrc(block))) {
+            reportMismatch(target.path, blockOffset, blockLength);
+        }
+    }
+    close(fd);
+    if (!success) errors_ += 1;
+    return true;
+}
+
+bool Crc32cScrubber::scrub() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+    }
+    if (lowPriorityIo_) setIdleIoPriority();
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        struct stat st;
+        if (stat(targets_[i].path.c_str(), &st) == 0) total += st.st_size;
+    }
+    passBytesTotal_ = total;
+    passBytesVerified_ = 0;
+    passStart_ = lastRefill_ = Clock::now();
+    passStartCpuNanos_ = threadCpuNanos();
+    tokens_ = CHUNK_SIZE;
+
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        const Target& target = targets_[i];
+        bool completed = target.hasSidecar ? scrubSidecar(target) : scrubFile(target);
+        if (!completed) return false;
+    }
+    passes_ += 1;
+    return true;
+}
+
+}  // namespace logging
@@ -0,0 +1,135 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_SCRUBBER_H__
+#define LOGGING_CRC32C_SCRUBBER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+// Re-verifies stored data against recorded CRCs in the background, without disturbing
+// foreground work. Targets are files with a known whole-file CRC, or files with a block CRC
+// sidecar (see Crc32cSidecar), which are verified block by block.
+//
+// Reads are limited by a token bucket to bytesPerSecond, with a burst of one chunk. After each
+// chunk, the scrubber sleeps if its thread has used more than cpuPercent of the elapsed time.
+// Before each chunk, it checks whether the machine is busy and if so pauses, with exponential
+// backoff, until it is not. On Linux, the scrubbing thread uses the idle I/O priority class.
+//
+// The counters may be read from other threads while scrub() runs.
+class Crc32cScrubber {
+public:
+    // Returns true if foreground load is high and scrubbing should pause.
+    typedef std::function<bool()> BusyFunction;
+    // Called for each range that does not match its recorded CRC.
+    typedef std::function<void(const std::string& path, uint64_t offset, uint64_t length)>
+            MismatchFunction;
+    // Called for each file whose size or modification time differs from its sidecar's.
+    typedef std::function<void(const std::string& path)> StaleFunction;
+
+    // Data is read and throttled in pieces of this size
+    static const size_t CHUNK_SIZE = 1 << 20;
+
+    // bytesPerSecond 0 means no limit.
+    explicit Crc32cScrubber(uint64_t bytesPerSecond, double cpuPercent = 100);
+
+    // Adds a file whose finished CRC32C should be crc.
+    void addFile(const std::string& path, uint32_t crc);
+    // Adds a file to verify against its sidecar, Crc32cSidecar::sidecarPath(path). If the file
+    // changed after the sidecar was written, it is reported as stale and not verified.
+    void addSidecarFile(const std::string& path);
+
+    // Replaces the default busy check, isLoadHigh.
+    void setBusyFunction(const BusyFunction& busy) { busy_ = busy; }
+    void setMismatchFunction(const MismatchFunction& mismatch) { mismatch_ = mismatch; }
+    void setStaleFunction(const StaleFunction& stale) { stale_ = stale; }
+    void setLowPriorityIo(bool lowPriorityIo) { lowPriorityIo_ = lowPriorityIo; }
+
+    // Verifies every target once. Returns false if stop() was called.
+    bool scrub();
+
+    // Makes a running scrub() return as soon as possible. May be called from any thread. The
+    // next scrub() starts a new pass.
+    void stop();
+
+    // Returns true if the one minute load average exceeds the number of CPUs.
+    static bool isLoadHigh();
+
+    // Bytes verified in all passes, and the bytes verified and to verify in the current pass.
+    uint64_t bytesVerified() const { return bytesVerified_; }
+    uint64_t passBytesVerified() const { return passBytesVerified_; }
+    uint64_t passBytesTotal() const { return passBytesTotal_; }
+    uint64_t passes() const { return passes_; }
+    // Files or sidecar blocks that did not match
+    uint64_t mismatches() const { return mismatches_; }
+    // Sidecar files that were skipped because the data file changed after they were written
+    uint64_t staleSidecars() const { return staleSidecars_; }
+    // Files or sidecars that could not be read
+    uint64_t errors() const { return errors_; }
+    // Times scrubbing paused because the machine was busy
+    uint64_t pauses() const { return pauses_; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Target {
+        std::string path;
+        bool hasSidecar;
+        uint32_t crc;
+    };
+
+    // Sleeps for duration or until stopped. Returns false if stopped.
+    bool sleep(Clock::duration duration);
+
+    // Waits until length bytes may be read and the machine is not busy. Returns false if
+    // stopped.
+    bool throttle(size_t length);
+
+    // Sleeps if the CPU time used exceeds the budget. Returns false if stopped.
+    bool limitCpu();
+
+    bool scrubFile(const Target& target);
+    bool scrubSidecar(const Target& target);
+    void reportMismatch(const std::string& path, uint64_t offset, uint64_t length);
+
+    uint64_t bytesPerSecond_;
+    double cpuFraction_;
+    bool lowPriorityIo_;
+    BusyFunction busy_;
+    MismatchFunction mismatch_;
+    StaleFunction stale_;
+    std::vector<Target> targets_;
+
+    // Token bucket: bytes that may be read now; negative after a read larger than the balance
+    double tokens_;
+    Clock::time_point lastRefill_;
+    Clock::time_point passStart_;
+    int64_t passStartCpuNanos_;
+
+    std::mutex mutex_;
+    std::condition_variable stopped_;
+    bool stop_;
+
+    std::atomic<uint64_t> bytesVerified_;
+    std::atomic<uint64_t> passBytesVerified_;
+    std::atomic<uint64_t> passBytesTotal_;
+    std::atomic<uint64_t> passes_;
+    std::atomic<uint64_t> mismatches_;
+    std::atomic<uint64_t> staleSidecars_;
+    std::atomic<uint64_t> errors_;
+    std::atomic<uint64_t> pauses_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,228 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_sidecar.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "crc32c.h"
+#include "crc32c_internal.h"
+
+namespace logging {
+
+static const char MAGIC[8] = { 'C', 'R', 'C', '3', '2', 'C', 'S', 'C' };
+static const uint32_t VERSION = 1;
+// Offset of the header CRC, which covers the bytes before it
+static const size_t HEADER_CRC_OFFSET = 44;
+// Data is read in pieces of at most this size, so huge block sizes do not need huge buffers
+static const size_t READ_SIZE = 1 << 20;
+
+const uint32_t Crc32cSidecar::DEFAULT_BLOCK_SIZE;
+const size_t Crc32cSidecar::HEADER_SIZE;
+
+static int64_t statMtimeNanos(const struct stat& st) {
+#ifdef __APPLE__
+    return (int64_t) st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+// Computes the finished CRC of up to length bytes at offset, using buffer (READ_SIZE bytes).
+// Returns the number of bytes read, or -1 on error.
+static ssize_t crcRange(int fd, uint64_t offset, size_t length, char* buffer, uint32_t* crc) {
+    uint32_t partial = crc32cInit();
+    size_t total = 0;
+    while (total < length) {
+        size_t pieceLength = std::min(READ_SIZE, length - total);
+        ssize_t bytes = preadFully(fd, buffer, pieceLength, offset + total);
+        if (bytes < 0) return -1;
+        partial = crc32c(partial, buffer, bytes);
+        total += bytes;
+        if ((size_t) bytes < pieceLength) break;
+    }
+    *crc = crc32cFinish(partial);
+    return total;
+}
+
+Crc32cSidecar::Crc32cSidecar() :
+        blockSize_(DEFAULT_BLOCK_SIZE), fileLength_(0), mtimeNanos_(0), fileCrc_(0) {
+}
+
+std::string Crc32cSidecar::sidecarPath(const std::string& path) {
+    return path + ".crc32c";
+}
+
+size_t Crc32cSidecar::blockLength(size_t block) const {
+    uint64_t offset = blockOffset(block);
+    return (size_t) std::min((uint64_t) blockSize_, fileLength_ - offset);
+}
+
+uint32_t Crc32cSidecar::combineBlocks(uint32_t blockSize, uint64_t fileLength,
+        const std::vector<uint32_t>& blockCrcs) {
+    // Every block but the last has the same length: compute its shift operator once
+    uint32_t op = crc32cShiftOperator(blockSize);
+    uint32_t crc = 0;
+    for (size_t i = 0; i < blockCrcs.size(); ++i) {
+        uint64_t offset = (uint64_t) i * blockSize;
+        size_t length = (size_t) std::min((uint64_t) blockSize, fileLength - offset);
+        if (length == blockSize) {
+            crc = crc32cShift(crc, op) ^ blockCrcs[i];
+        } else {
+            crc = crc32cCombine(crc, blockCrcs[i], length);
+        }
+    }
+    return crc;
+}
+
+bool Crc32cSidecar::compute(int fd, uint32_t blockSize) {
+    if (blockSize == 0) {
+        errno = EINVAL;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+
+    blockSize_ = blockSize;
+    mtimeNanos_ = statMtimeNanos(st);
+    blockCrcs_.clear();
+    blockCrcs_.reserve(st.st_size / blockSize + 1);
+
+    std::vector<char> buffer(std::min((size_t) blockSize, READ_SIZE));
+    uint64_t offset = 0;
+    while (true) {
+        uint32_t crc;
+        ssize_t bytes = crcRange(fd, offset, blockSize, &buffer[0], &crc);
+        if (bytes < 0) return false;
+        if (bytes == 0) break;
+        blockCrcs_.push_back(crc);
+        offset += bytes;
+        if ((size_t) bytes < blockSize) break;
+    }
+    fileLength_ = offset;
+    fileCrc_ = combineBlocks(blockSize_, fileLength_, blockCrcs_);
+    return true;
+}
+
+bool Crc32cSidecar::write(const std::string& path) const {
+    std::vector<char> contents(HEADER_SIZE + 4 * blockCrcs_.size());
+    char* table = &contents[HEADER_SIZE];
+    for (size_t i = 0; i < blockCrcs_.size(); ++i) {
+        putU32(table + 4 * i, blockCrcs_[i]);
+    }
+
+    char* header = &contents[0];
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    putU32(header + 8, VERSION);
+    putU32(header + 12, blockSize_);
+    putU64(header + 16, fileLength_);
+    putU64(header + 24, (uint64_t) mtimeNanos_);
+    putU32(header + 32, fileCrc_);
+    putU32(header + 36, oneshot(table, 4 * blockCrcs_.size()));
+    putU32(header + 40, 0);
+    putU32(header + HEADER_CRC_OFFSET, oneshot(header, HEADER_CRC_OFFSET));
+
+    // Write a temporary file then rename it, so readers never see a partial sidecar
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return false;
+    bool success = writeFully(fd, &contents[0], contents.size()) && fsync(fd) == 0;
+    int error = errno;
+    if (close(fd) != 0 && success) {
+        success = false;
+        error = errno;
+    }
+    if (success && rename(temporary.c_str(), path.c_str()) == 0) return true;
+    if (success) error = errno;
+    unlink(temporary.c_str());
+    errno = error;
+    return false;
+}
+
+bool Crc32cSidecar::read(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return false;
+    }
+    std::vector<char> contents(st.st_size);
+    ssize_t bytes = preadFully(fd, contents.data(), contents.size(), 0);
+    int error = errno;
+    close(fd);
+    if (bytes < 0) {
+        errno = error;
+        return false;
+    }
+
+    errno = EINVAL;
+    if ((size_t) bytes != contents.size() || contents.size() < HEADER_SIZE) return false;
+    const char* header = &contents[0];
+    if (memcmp(header, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (getU32(header + HEADER_CRC_OFFSET) != oneshot(header, HEADER_CRC_OFFSET)) return false;
+    if (getU32(header + 8) != VERSION) return false;
+
+    uint32_t blockSize = getU32(header + 12);
+    uint64_t fileLength = getU64(header + 16);
+    if (blockSize == 0) return false;
+    uint64_t numBlocks = fileLength / blockSize + (fileLength % blockSize != 0);
+    if ((contents.size() - HEADER_SIZE) / 4 != numBlocks ||
+            (contents.size() - HEADER_SIZE) % 4 != 0) {
+        return false;
+    }
+    const char* table = &contents[HEADER_SIZE];
+    if (getU32(header + 36) != oneshot(table, 4 * numBlocks)) return false;
+
+    std::vector<uint32_t> blockCrcs(numBlocks);
+    for (size_t i = 0; i < numBlocks; ++i) {
+        blockCrcs[i] = getU32(table + 4 * i);
+    }
+    uint32_t fileCrc = combineBlocks(blockSize, fileLength, blockCrcs);
+    if (fileCrc != getU32(header + 32)) return false;
+
+    // Only replace this sidecar once the new one is known to be good
+    blockSize_ = blockSize;
+    fileLength_ = fileLength;
+    mtimeNanos_ = (int64_t) getU64(header + 24);
+    fileCrc_ = fileCrc;
+    blockCrcs_.swap(blockCrcs);
+    errno = 0;
+    return true;
+}
+
+bool Crc32cSidecar::matchesFile(int fd) const {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    return (uint64_t) st.st_size == fileLength_ && statMtimeNanos(st) == mtimeNanos_;
+}
+
+bool Crc32cSidecar::verify(int fd, uint64_t offset, uint64_t length,
+        std::vector<size_t>* badBlocks) const {
+    if (offset >= fileLength_ || length == 0) return true;
+    uint64_t end = fileLength_ - offset < length ? fileLength_ : offset + length;
+    size_t first = offset / blockSize_;
+    size_t last = (end - 1) / blockSize_;
+
+    std::vector<char> buffer(std::min((size_t) blockSize_, READ_SIZE));
+    for (size_t block = first; block <= last; ++block) {
+        uint32_t crc;
+        ssize_t bytes = crcRange(fd, blockOffset(block), blockLength(block), &buffer[0], &crc);
+        if (bytes < 0) return false;
+        if ((size_t) bytes != blockLength(block) || crc != blockCrcs_[block]) {
+            badBlocks->push_back(block);
+        }
+    }
+    return true;
+}
+
+}  // namespace logging
@@ -0,0 +1,90 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_SIDECAR_H__
+#define LOGGING_CRC32C_SIDECAR_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+// Per-block CRC32C values of a data file, stored in a small "sidecar" file next to it. A range of
+// the data file can be verified by reading only the blocks it touches, so corruption in a very
+// large file can be found without a full scan.
+//
+// File format, all integers little endian:
+//
+//   offset size
+//        0    8  magic "CRC32CSC"
+//        8    4  version (1)
+//       12    4  block size in bytes
+//       16    8  data file length in bytes
+//       24    8  data file mtime, in nanoseconds since the epoch
+//       32    4  finished CRC32C of the whole data file
+//       36    4  finished CRC32C of the block CRC table
+//       40    4  reserved, zero
+//       44    4  finished CRC32C of header bytes [0, 44)
+//       48       finished CRC32C of each block, ceil(length / block size) * 4 bytes. The last
+//                block may be short.
+//
+// The whole file CRC is derived from the block CRCs with crc32cCombine, not by a second pass.
+class Crc32cSidecar {
+public:
+    static const uint32_t DEFAULT_BLOCK_SIZE = 1 << 20;
+    static const size_t HEADER_SIZE = 48;
+
+    Crc32cSidecar();
+
+    // Returns the conventional sidecar path for the data file at path: path + ".crc32c".
+    static std::string sidecarPath(const std::string& path);
+
+    // Computes the block CRCs of the open file fd, reading it from the start. Returns false and
+    // sets errno on an I/O error.
+    bool compute(int fd, uint32_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    // Writes the sidecar to path, replacing it atomically. Returns false and sets errno on error.
+    bool write(const std::string& path) const;
+
+    // Reads the sidecar at path. Returns false if it cannot be read, or if it is malformed or
+    // corrupt (errno is then EINVAL).
+    bool read(const std::string& path);
+
+    // Returns true if fd has the length and modification time recorded in the header. If not,
+    // the data file was changed after the sidecar was computed.
+    bool matchesFile(int fd) const;
+
+    // Verifies bytes [offset, offset + length) of fd, clipped to the recorded length, reading
+    // only the blocks that overlap the range. Appends the index of each block with a CRC
+    // mismatch or that could not be fully read to badBlocks. Returns false on an I/O error.
+    bool verify(int fd, uint64_t offset, uint64_t length, std::vector<size_t>* badBlocks) const;
+
+    uint32_t blockSize() const { return blockSize_; }
+    uint64_t fileLength() const { return fileLength_; }
+    int64_t mtimeNanos() const { return mtimeNanos_; }
+    uint32_t fileCrc() const { return fileCrc_; }
+    size_t numBlocks() const { return blockCrcs_.size(); }
+    uint32_t blockCrc(size_t block) const { return blockCrcs_[block]; }
+
+    // Returns the offset and length of block in the data file.
+    uint64_t blockOffset(size_t block) const { return (uint64_t) block * blockSize_; }
+    size_t blockLength(size_t block) const;
+
+private:
+    // Returns the CRC of a file of fileLength bytes from the CRCs of its blocks of blockSize.
+    static uint32_t combineBlocks(uint32_t blockSize, uint64_t fileLength,
+            const std::vector<uint32_t>& blockCrcs);
+
+    uint32_t blockSize_;
+    uint64_t fileLength_;
+    int64_t mtimeNanos_;
+    uint32_t fileCrc_;
+    std::vector<uint32_t> blockCrcs_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,46 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_state.h"
+
+#include <cassert>
+
+namespace logging {
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t Crc32cState::DEFAULT_PIECE_SIZE;
+
+Crc32cState::Crc32cState(uint32_t crc) : data_(0), remaining_(0), consumed_(0), crc_(crc) {
+}
+
+Crc32cState::Crc32cState(const void* data, size_t length, uint32_t crc) :
+        data_((const char*) data), remaining_(length), consumed_(0), crc_(crc) {
+}
+
+void Crc32cState::feed(const void* data, size_t length) {
+    assert(done());
+    data_ = (const char*) data;
+    remaining_ = length;
+}
+
+bool Crc32cState::step(size_t maxBytes) {
+    size_t length = maxBytes < remaining_ ? maxBytes : remaining_;
+    crc_ = crc32c(crc_, data_, length);
+    data_ += length;
+    remaining_ -= length;
+    consumed_ += length;
+    return done();
+}
+
+bool Crc32cState::stepFor(std::chrono::nanoseconds budget, size_t pieceSize) {
+    assert(pieceSize > 0);
+    Clock::time_point deadline = Clock::now() + budget;
+    while (!step(pieceSize)) {
+        if (Clock::now() >= deadline) return false;
+    }
+    return true;
+}
+
+}  // namespace logging
@@ -0,0 +1,74 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_STATE_H__
+#define LOGGING_CRC32C_STATE_H__
+
+#include <chrono>
+#include <cstddef>
+#include <stdint.h>
+
+#include "crc32c.h"
+
+namespace logging {
+
+// A resumable CRC32C of a buffer, for single-threaded event loops. A large buffer checksummed
+// in one crc32c() call blocks every other task until it is done; instead, each call to step()
+// or stepFor() does a bounded amount of work and returns, and the loop calls it again on a
+// later iteration until done() is true.
+//
+// Usage, from a task scheduled by the event loop:
+//   if (!state.stepFor(std::chrono::microseconds(200))) {
+//       reschedule();
+//       return;
+//   }
+//   uint32_t crc = state.finish();
+class Crc32cState {
+public:
+    // The unit of work for stepFor(): the clock is read once per piece. A piece takes a few
+    // microseconds with the CRC32 instruction.
+    static const size_t DEFAULT_PIECE_SIZE = 64 << 10;
+
+    // Starts a CRC after the bytes whose unfinished CRC is crc, with no data.
+    explicit Crc32cState(uint32_t crc = crc32cInit());
+
+    // Starts checksumming length bytes at data, which must remain valid until done().
+    Crc32cState(const void* data, size_t length, uint32_t crc = crc32cInit());
+
+    // Queues length more bytes at data, continuing the CRC. The previous buffer must be done.
+    void feed(const void* data, size_t length);
+
+    // Checksums up to maxBytes of the buffer. Returns true if the buffer is done.
+    bool step(size_t maxBytes);
+
+    // Checksums the buffer in pieces of pieceSize bytes until it is done or budget has elapsed.
+    // At least one piece is checksummed, so every call makes progress. Returns true if the
+    // buffer is done.
+    bool stepFor(std::chrono::nanoseconds budget, size_t pieceSize = DEFAULT_PIECE_SIZE);
+
+    // Returns true once every byte that was fed has been checksummed.
+    bool done() const { return remaining_ == 0; }
+
+    // Returns the number of bytes of the current buffer not yet checksummed.
+    size_t remaining() const { return remaining_; }
+
+    // Returns the number of bytes checksummed, over every buffer fed.
+    uint64_t consumed() const { return consumed_; }
+
+    // Returns the unfinished CRC of the bytes checksummed so far.
+    uint32_t value() const { return crc_; }
+
+    // Returns the finished CRC of the bytes checksummed so far.
+    uint32_t finish() const { return crc32cFinish(crc_); }
+
+private:
+    const char* data_;
+    size_t remaining_;
+    uint64_t consumed_;
+    uint32_t crc_;
+};
+
+}  // namespace logging
+
+#endif
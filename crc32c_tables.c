@@ -476,3 +476,39 @@ const uint32_t crc_tableil8_o88[256] =
 /*
  * end of the CRC lookup table crc_tableil8_o88
  */
+
+/*
+ * crc_shift_table[i] is x^(8 * 2^i) mod P(x), in the same reflected bit order as the CRC. Multiplying
+ * a CRC by it modulo P(x) appends 2^i zero bytes. Generated by repeated squaring, starting from
+ * x^8 (0x00800000). The sequence repeats with a period of 31.
+ */
+
+const uint32_t crc_shift_table[64] =
+{
+    0x00800000, 0x00008000, 0x82F63B78, 0x6EA2D55C, 0x18B8EA18, 0x510AC59A, 0xB82BE955, 0xB8FDB1E7,
+    0x88E56F72, 0x74C360A4, 0xE4172B16, 0x0D65762A, 0x35D73A62, 0x28461564, 0xBF455269, 0xE2EA32DC,
+    0xFE7740E6, 0xF946610B, 0x3C204F8F, 0x538586E3, 0x59726915, 0x734D5309, 0xBC1AC763, 0x7D0722CC,
+    0xD289CABE, 0xE94CA9BC, 0x05B74F3F, 0xA51E1F42, 0x40000000, 0x20000000, 0x08000000, 0x00800000,
+    0x00008000, 0x82F63B78, 0x6EA2D55C, 0x18B8EA18, 0x510AC59A, 0xB82BE955, 0xB8FDB1E7, 0x88E56F72,
+    0x74C360A4, 0xE4172B16, 0x0D65762A, 0x35D73A62, 0x28461564, 0xBF455269, 0xE2EA32DC, 0xFE7740E6,
+    0xF946610B, 0x3C204F8F, 0x538586E3, 0x59726915, 0x734D5309, 0xBC1AC763, 0x7D0722CC, 0xD289CABE,
+    0xE94CA9BC, 0x05B74F3F, 0xA51E1F42, 0x40000000, 0x20000000, 0x08000000, 0x00800000, 0x00008000
+};
+
+/*
+ * crc_unshift_table[i] is x^(-8 * 2^i) mod P(x), the inverse of crc_shift_table[i]. Multiplying a
+ * CRC by it removes 2^i trailing zero bytes. x^-1 mod P(x) is (P(x) - 1) / x, which is 0x05EC76F1
+ * in reflected bit order; the table starts from its 8th power (0xFDE39562).
+ */
+
+const uint32_t crc_unshift_table[64] =
+{
+    0xFDE39562, 0xBEF0965E, 0xD610D67E, 0xE67CCE65, 0xA268B79E, 0x134FB088, 0x32998D96, 0xCEDAC2CC,
+    0x70118575, 0x0E004A40, 0xA7864C8B, 0xBC7BE916, 0x10BA2894, 0x6077197B, 0x98448E4E, 0x8BAF845D,
+    0xE93E07FC, 0xF58027D7, 0x5E2B422D, 0x9DB2851C, 0x9270ED25, 0x5984E7B3, 0x7AF026F1, 0xE0F4116B,
+    0xACE8A6B0, 0x9E09F006, 0x6A60EA71, 0x4FD04875, 0x05EC76F1, 0x0BD8EDE2, 0x2F63B788, 0xFDE39562,
+    0xBEF0965E, 0xD610D67E, 0xE67CCE65, 0xA268B79E, 0x134FB088, 0x32998D96, 0xCEDAC2CC, 0x70118575,
+    0x0E004A40, 0xA7864C8B, 0xBC7BE916, 0x10BA2894, 0x6077197B, 0x98448E4E, 0x8BAF845D, 0xE93E07FC,
+    0xF58027D7, 0x5E2B422D, 0x9DB2851C, 0x9270ED25, 0x5984E7B3, 0x7AF026F1, 0xE0F4116B, 0xACE8A6B0,
+    0x9E09F006, 0x6A60EA71, 0x4FD04875, 0x05EC76F1, 0x0BD8EDE2, 0x2F63B788, 0xFDE39562, 0xBEF0965E
+};
@@ -20,6 +20,9 @@ extern const uint32_t crc_tableil8_o72[256];
 extern const uint32_t crc_tableil8_o80[256];
 extern const uint32_t crc_tableil8_o88[256];
 
+extern const uint32_t crc_shift_table[64];
+extern const uint32_t crc_unshift_table[64];
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,160 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "crc32c_tee.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_internal.h"
+
+namespace logging {
+
+static const size_t BUFFER_SIZE = 1 << 20;
+
+namespace {
+
+// Computes the CRC of the stream and reports checkpoints.
+class StreamChecksum {
+public:
+    StreamChecksum(uint64_t checkpointInterval, Crc32cCheckpointFunction checkpoint,
+            void* context) :
+            checkpoint_(checkpoint), context_(context),
+            checkpointInterval_(checkpoint == 0 ? 0 : checkpointInterval), crc_(crc32cInit()),
+            length_(0),
+            nextCheckpoint_(checkpointInterval_ == 0 ? UINT64_MAX : checkpointInterval_) {
+    }
+
+    // Adds bytes to the CRC. Checkpoints are reported by reportCheckpoints.
+    void update(const char* data, size_t length) {
+        while (length > 0) {
+            size_t pieceLength = length;
+            if (nextCheckpoint_ - length_ < pieceLength) pieceLength = nextCheckpoint_ - length_;
+            crc_ = crc32c(crc_, data, pieceLength);
+            data += pieceLength;
+            length -= pieceLength;
+            length_ += pieceLength;
+            if (length_ == nextCheckpoint_) {
+                checkpoints_.push_back(Checkpoint(length_, crc32cFinish(crc_)));
+                nextCheckpoint_ += checkpointInterval_;
+            }
+        }
+    }
+
+    // Calls the checkpoint function for the checkpoints since the last call. Called once the
+    // data has been written, so the reader of out has the bytes each checkpoint covers.
+    void reportCheckpoints() {
+        for (size_t i = 0; i < checkpoints_.size(); ++i) {
+            checkpoint_(context_, checkpoints_[i].first, checkpoints_[i].second);
+        }
+        checkpoints_.clear();
+    }
+
+    uint32_t crc() const { return crc32cFinish(crc_); }
+    uint64_t length() const { return length_; }
+
+private:
+    // Offset and finished CRC
+    typedef std::pair<uint64_t, uint32_t> Checkpoint;
+
+    Crc32cCheckpointFunction checkpoint_;
+    void* context_;
+    uint64_t checkpointInterval_;
+    uint32_t crc_;
+    uint64_t length_;
+    uint64_t nextCheckpoint_;
+    std::vector<Checkpoint> checkpoints_;
+};
+
+}  // namespace
+
+static bool isPipe(int fd) {
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+#ifdef __linux__
+// Duplicates the data in the pipe in to the pipe out with tee(2), then consumes it from in.
+// Returns false with errno EINVAL if tee is not supported, before anything is copied.
+static bool teePipes(int in, int out, char* buffer, StreamChecksum* checksum) {
+    // A larger pipe means fewer system calls per byte; failure is harmless
+    fcntl(out, F_SETPIPE_SZ, (int) BUFFER_SIZE);
+    while (true) {
+        ssize_t teed = tee(in, out, BUFFER_SIZE, 0);
+        if (teed < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (teed == 0) return true;
+
+        // The bytes are in the pipe: read exactly those
+        size_t remaining = teed;
+        while (remaining > 0) {
+            ssize_t bytes = read(in, buffer, remaining < BUFFER_SIZE ? remaining : BUFFER_SIZE);
+            if (bytes < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (bytes == 0) {
+                errno = EIO;
+                return false;
+            }
+            checksum->update(buffer, bytes);
+            remaining -= bytes;
+        }
+        checksum->reportCheckpoints();
+    }
+}
+#endif
+
+static bool copyBuffered(int in, int out, char* buffer, StreamChecksum* checksum) {
+    while (true) {
+        ssize_t bytes = read(in, buffer, BUFFER_SIZE);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (bytes == 0) return true;
+        checksum->update(buffer, bytes);
+        if (!writeFully(out, buffer, bytes)) return false;
+        checksum->reportCheckpoints();
+    }
+}
+
+bool crc32cTee(int in, int out, uint32_t* crc, uint64_t* length,
+        uint64_t checkpointInterval, Crc32cCheckpointFunction checkpoint, void* context) {
+    std::vector<char> buffer(BUFFER_SIZE);
+    StreamChecksum checksum(checkpointInterval, checkpoint, context);
+    bool success;
+#ifdef __linux__
+    if (isPipe(in) && isPipe(out)) {
+        success = teePipes(in, out, &buffer[0], &checksum);
+        // tee is not supported: nothing was copied
+        if (!success && errno == EINVAL && checksum.length() == 0) {
+            success = copyBuffered(in, out, &buffer[0], &checksum);
+        }
+    } else {
+        success = copyBuffered(in, out, &buffer[0], &checksum);
+    }
+#else
+    (void) isPipe;
+    success = copyBuffered(in, out, &buffer[0], &checksum);
+#endif
+    if (!success) return false;
+    *crc = checksum.crc();
+    *length = checksum.length();
+    return true;
+}
+
+}  // namespace logging
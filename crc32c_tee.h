@@ -0,0 +1,30 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_TEE_H__
+#define LOGGING_CRC32C_TEE_H__
+
+#include <stdint.h>
+
+namespace logging {
+
+// Called by crc32cTee with the finished CRC32C of the first offset bytes of the stream.
+typedef void (*Crc32cCheckpointFunction)(void* context, uint64_t offset, uint32_t crc);
+
+// Copies everything readable from in to out, computing its CRC32C on the way. Sets *crc to the
+// finished CRC and *length to the number of bytes copied.
+//
+// On Linux, when in and out are both pipes, the data is duplicated into out with tee(2), which
+// copies no data, then read from in once to checksum it. Otherwise it is copied through a large
+// buffer.
+//
+// If checkpointInterval is not 0, checkpoint is called every checkpointInterval bytes, after
+// the bytes have been written. Returns false and sets errno on error.
+bool crc32cTee(int in, int out, uint32_t* crc, uint64_t* length,
+        uint64_t checkpointInterval = 0, Crc32cCheckpointFunction checkpoint = 0,
+        void* context = 0);
+
+}  // namespace logging
+
+#endif
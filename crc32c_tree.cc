@@ -0,0 +1,415 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_tree.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_cache.h"
+#include "crc32c_file.h"
+
+namespace logging {
+
+const uint64_t Crc32cTreeChecksummer::DEFAULT_RANGE_SIZE;
+const int Crc32cTreeChecksummer::DEFAULT_MAX_OPEN_FILES;
+const size_t Crc32cTreeChecksummer::DEFAULT_MAX_PENDING_FILES;
+
+namespace {
+
+// An open file being checksummed.
+struct FileState {
+    uint64_t sequence;
+    std::string path;
+    int fd;
+    // From before the file was read, for the cache
+    struct stat st;
+    uint64_t length;
+    // Finished CRC of each range
+    std::vector<uint32_t> rangeCrcs;
+    std::atomic<size_t> remainingRanges;
+    std::atomic<int> error;
+};
+
+// A range of a file to checksum. Files with a single range are one task.
+struct Task {
+    FileState* file;
+    size_t range;
+};
+
+// A deque of tasks: the owner works from the back, thieves take from the front, so a thief takes
+// the oldest task, which for a split file is the range furthest from the owner's.
+class TaskDeque {
+public:
+    void push(const Task& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(task);
+    }
+
+    bool pop(Task* task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty()) return false;
+        *task = tasks_.back();
+        tasks_.pop_back();
+        return true;
+    }
+
+    bool steal(Task* task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty()) return false;
+        *task = tasks_.front();
+        tasks_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Task> tasks_;
+};
+
+class TreeRun {
+public:
+    TreeRun(int threads, uint64_t rangeSize, int maxOpenFiles, size_t maxPendingFiles,
+            Crc32cCache* cache, const Crc32cTreeChecksummer::ResultFunction& report) :
+            rangeSize_(rangeSize), maxOpenFiles_(maxOpenFiles),
+            maxPendingFiles_(maxPendingFiles), cache_(cache), report_(report), deques_(threads),
+            nextSequence_(0), nextReport_(0), openFiles_(0), queuedTasks_(0),
+            outstandingTasks_(0), walkDone_(false) {
+    }
+
+    void run(const std::string& root, bool rootIsDirectory) {
+        // Resolve the crc32c() kernel on this thread: the first call replaces the function
+        // pointer
+        crc32c(crc32cInit(), NULL, 0);
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < deques_.size(); ++i) {
+            workers.push_back(std::thread(&TreeRun::work, this, i));
+        }
+        if (rootIsDirectory) {
+            walk(root);
+        } else {
+            addFile(root);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            walkDone_ = true;
+            workAvailable_.notify_all();
+        }
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+        assert(pending_.empty());
+    }
+
+private:
+    // Visits the entries of directory in sorted order.
+    void walk(const std::string& directory) {
+        DIR* dir = opendir(directory.c_str());
+        if (dir == NULL) {
+            reportError(directory, errno);
+            return;
+        }
+        std::vector<std::string> names;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+
+        for (size_t i = 0; i < names.size(); ++i) {
+            std::string path = directory + "/" + names[i];
+            struct stat st;
+            if (lstat(path.c_str(), &st) != 0) {
+                reportError(path, errno);
+            } else if (S_ISDIR(st.st_mode)) {
+                walk(path);
+            } else if (S_ISREG(st.st_mode)) {
+                addFile(path);
+            }
+        }
+    }
+
+    // Reserves the next sequence number, waiting while too many files are pending.
+    uint64_t nextSequence() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (nextSequence_ - nextReport_ >= maxPendingFiles_) {
+            resultReported_.wait(lock);
+        }
+        return nextSequence_++;
+    }
+
+    void reportError(const std::string& path, int error) {
+        Crc32cTreeResult result;
+        result.path = path;
+        result.length = 0;
+        result.crc = 0;
+        result.error = error;
+        finish(nextSequence(), result);
+    }
+
+    // Opens path and queues its tasks.
+    void addFile(const std::string& path) {
+        uint64_t sequence = nextSequence();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (openFiles_ >= maxOpenFiles_) {
+                fileClosed_.wait(lock);
+            }
+            openFiles_ += 1;
+        }
+
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            int error = errno;
+            if (fd >= 0) close(fd);
+            closeFile();
+            Crc32cTreeResult result;
+            result.path = path;
+            result.length = 0;
+            result.crc = 0;
+            result.error = error;
+            finish(sequence, result);
+            return;
+        }
+
+        uint32_t cachedCrc;
+        if (lookupCache(st, &cachedCrc)) {
+            close(fd);
+            closeFile();
+            Crc32cTreeResult result;
+            result.path = path;
+            result.length = st.st_size;
+            result.crc = cachedCrc;
+            result.error = 0;
+            finish(sequence, result);
+            return;
+        }
+
+        FileState* file = new FileState;
+        file->sequence = sequence;
+        file->path = path;
+        file->fd = fd;
+        file->st = st;
+        file->length = st.st_size;
+        size_t numRanges = file->length <= rangeSize_ ? 1 :
+                (size_t) ((file->length + rangeSize_ - 1) / rangeSize_);
+        file->rangeCrcs.resize(numRanges);
+        file->remainingRanges = numRanges;
+        file->error = 0;
+
+        // Only the first task is queued: the worker that runs it queues the other ranges on
+        // its own deque, where they can be stolen
+        Task task = { file, 0 };
+        push(sequence % deques_.size(), task);
+    }
+
+    void push(size_t worker, const Task& task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queuedTasks_ += 1;
+        outstandingTasks_ += 1;
+        deques_[worker].push(task);
+        workAvailable_.notify_one();
+    }
+
+    void taskDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outstandingTasks_ -= 1;
+        if (walkDone_ && outstandingTasks_ == 0) workAvailable_.notify_all();
+    }
+
+    bool lookupCache(const struct stat& st, uint32_t* crc) {
+        if (cache_ == NULL) return false;
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        return cache_->lookup(st, crc);
+    }
+
+    void closeFile() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            openFiles_ -= 1;
+        }
+        fileClosed_.notify_one();
+    }
+
+    // Finds a task: from the worker's own deque, or stolen from another. Returns false when
+    // there is no more work.
+    bool getTask(size_t worker, Task* task) {
+        while (true) {
+            if (takeTask(worker, task)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queuedTasks_ -= 1;
+                return true;
+            }
+            // push() counts the task and notifies under the lock, so the wakeup is not missed
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this] {
+                return queuedTasks_ > 0 || (walkDone_ && outstandingTasks_ == 0);
+            });
+            if (queuedTasks_ == 0) return false;
+        }
+    }
+
+    bool takeTask(size_t worker, Task* task) {
+        if (deques_[worker].pop(task)) return true;
+        for (size_t i = 1; i < deques_.size(); ++i) {
+            if (deques_[(worker + i) % deques_.size()].steal(task)) return true;
+        }
+        return false;
+    }
+
+    void work(size_t worker) {
+        Task task;
+        while (getTask(worker, &task)) {
+            FileState* file = task.file;
+            size_t numRanges = file->rangeCrcs.size();
+            if (task.range == 0 && numRanges > 1) {
+                // Queue the other ranges in reverse, so this worker continues in file order
+                // and thieves start from the end
+                for (size_t i = numRanges - 1; i > 0; --i) {
+                    Task range = { file, i };
+                    push(worker, range);
+                }
+            }
+
+            uint64_t offset = task.range * rangeSize_;
+            uint64_t length = std::min(rangeSize_, file->length - offset);
+            uint64_t checksummed;
+            uint32_t crc;
+            if (!crc32cFileRange(file->fd, offset, length, &crc, &checksummed)) {
+                file->error = errno;
+            } else if (checksummed != length) {
+                // Truncated while it was read
+                file->error = EIO;
+            }
+            file->rangeCrcs[task.range] = crc;
+            if (--file->remainingRanges == 0) {
+                finishFile(file);
+            }
+            taskDone();
+        }
+    }
+
+    void finishFile(FileState* file) {
+        Crc32cTreeResult result;
+        result.path = file->path;
+        result.length = file->length;
+        result.error = file->error;
+        result.crc = 0;
+        if (result.error == 0) {
+            uint32_t crc = file->rangeCrcs[0];
+            for (size_t i = 1; i < file->rangeCrcs.size(); ++i) {
+                uint64_t offset = i * rangeSize_;
+                crc = crc32cCombine(crc, file->rangeCrcs[i],
+                        (size_t) std::min(rangeSize_, file->length - offset));
+            }
+            result.crc = crc;
+            if (cache_ != NULL) {
+                std::lock_guard<std::mutex> lock(cacheMutex_);
+                cache_->insertIfUnchanged(file->st, file->fd, crc);
+            }
+        }
+        close(file->fd);
+        closeFile();
+
+        uint64_t sequence = file->sequence;
+        delete file;
+        finish(sequence, result);
+    }
+
+    // Reports the results that are next in sequence. report_ is called with the lock held, so
+    // calls are serialized and in order.
+    void finish(uint64_t sequence, const Crc32cTreeResult& result) {
+        std::lock_guard<std::mutex> lock(reportMutex_);
+        pending_[sequence] = result;
+        bool reported = false;
+        while (!pending_.empty() && pending_.begin()->first == nextReported()) {
+            report_(pending_.begin()->second);
+            pending_.erase(pending_.begin());
+            {
+                std::lock_guard<std::mutex> countLock(mutex_);
+                nextReport_ += 1;
+            }
+            reported = true;
+        }
+        if (reported) resultReported_.notify_all();
+    }
+
+    uint64_t nextReported() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nextReport_;
+    }
+
+    uint64_t rangeSize_;
+    int maxOpenFiles_;
+    size_t maxPendingFiles_;
+    Crc32cCache* cache_;
+    // Serializes use of cache_, which is not thread safe
+    std::mutex cacheMutex_;
+    const Crc32cTreeChecksummer::ResultFunction& report_;
+    std::vector<TaskDeque> deques_;
+
+    // Protects the counters below and is used with the condition variables
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable fileClosed_;
+    std::condition_variable resultReported_;
+    uint64_t nextSequence_;
+    uint64_t nextReport_;
+    int openFiles_;
+    // Tasks in the deques, and tasks queued or running
+    size_t queuedTasks_;
+    size_t outstandingTasks_;
+    bool walkDone_;
+
+    // Protects pending_ and serializes calls to report_
+    std::mutex reportMutex_;
+    // Results waiting for earlier results to be reported
+    std::map<uint64_t, Crc32cTreeResult> pending_;
+};
+
+}  // namespace
+
+Crc32cTreeChecksummer::Crc32cTreeChecksummer(int threads, uint64_t rangeSize, int maxOpenFiles,
+        size_t maxPendingFiles) :
+        threads_(threads < 1 ? 1 : threads), rangeSize_(rangeSize == 0 ? 1 : rangeSize),
+        maxOpenFiles_(maxOpenFiles < 1 ? 1 : maxOpenFiles),
+        maxPendingFiles_(maxPendingFiles < 1 ? 1 : maxPendingFiles), cache_(NULL) {
+}
+
+bool Crc32cTreeChecksummer::run(const std::string& root, const ResultFunction& report) {
+    struct stat st;
+    if (stat(root.c_str(), &st) != 0) return false;
+    if (S_ISDIR(st.st_mode)) {
+        // Fail early if the root cannot be listed
+        DIR* dir = opendir(root.c_str());
+        if (dir == NULL) return false;
+        closedir(dir);
+    }
+    TreeRun run(threads_, rangeSize_, maxOpenFiles_, maxPendingFiles_, cache_, report);
+    run.run(root, S_ISDIR(st.st_mode));
+    return true;
+}
+
+}  // namespace logging
@@ -0,0 +1,74 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_TREE_H__
+#define LOGGING_CRC32C_TREE_H__
+
+#include <cstddef>
+#include <functional>
+#include <stdint.h>
+#include <string>
+
+namespace logging {
+
+class Crc32cCache;
+
+// The CRC of one file in a tree, or the error that prevented computing it.
+struct Crc32cTreeResult {
+    std::string path;
+    uint64_t length;
+    uint32_t crc;
+    // errno of the failure, or 0
+    int error;
+};
+
+// Computes the CRC32C of every regular file under a directory, in parallel.
+//
+// One thread walks the tree in sorted depth first order and opens the files. Files are checksummed
+// by a pool of worker threads, each with its own task deque: a worker takes tasks from the back of
+// its deque, and when that is empty steals from the front of another's. Files longer than
+// rangeSize are split into range tasks on the deque of the worker that opened them, so idle
+// workers steal ranges of a large file while the owner works on the rest; the range CRCs are
+// joined with crc32cCombine. Files are read with crc32cFileRange, so holes are not read.
+//
+// Resources are bounded: at most maxOpenFiles files are open at once, at most maxPendingFiles
+// files are queued or waiting to be reported, and each worker uses one read buffer.
+//
+// Results are reported in walk order regardless of which thread finishes first. Symbolic links
+// and special files are skipped.
+//
+// With a Crc32cCache, files whose CRC is cached are not read, and the CRCs of files that are
+// read are stored. The cache is only used by one thread at a time.
+class Crc32cTreeChecksummer {
+public:
+    typedef std::function<void(const Crc32cTreeResult&)> ResultFunction;
+
+    static const uint64_t DEFAULT_RANGE_SIZE = 64 << 20;
+    static const int DEFAULT_MAX_OPEN_FILES = 256;
+    static const size_t DEFAULT_MAX_PENDING_FILES = 65536;
+
+    explicit Crc32cTreeChecksummer(int threads, uint64_t rangeSize = DEFAULT_RANGE_SIZE,
+            int maxOpenFiles = DEFAULT_MAX_OPEN_FILES,
+            size_t maxPendingFiles = DEFAULT_MAX_PENDING_FILES);
+
+    // Looks up and stores file CRCs in cache, which must remain open during run(). NULL, the
+    // default, disables caching.
+    void setCache(Crc32cCache* cache) { cache_ = cache; }
+
+    // Checksums every file under root, or root itself if it is a file, calling report for each
+    // from one thread at a time. Paths are root followed by the path within it. Returns false and
+    // sets errno if root cannot be read; errors for other paths are reported as results.
+    bool run(const std::string& root, const ResultFunction& report);
+
+private:
+    int threads_;
+    uint64_t rangeSize_;
+    int maxOpenFiles_;
+    size_t maxPendingFiles_;
+    Crc32cCache* cache_;
+};
+
+}  // namespace logging
+
+#endif
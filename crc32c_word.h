@@ -0,0 +1,70 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_WORD_H__
+#define LOGGING_CRC32C_WORD_H__
+
+#include <stdint.h>
+
+#include "crc32c.h"
+
+namespace logging {
+
+// Inline CRC32C steps of one byte or one 64-bit word, for code that adds a few bytes at a time
+// and cannot afford a call through the crc32c pointer for each. They dispatch at run time the
+// same way crc32c() does: the CRC32 instruction if the CPU has it, the tables if not. The check
+// is a load of crc32cHardwareState and a branch that is always predicted.
+
+// Returns true if the CRC32 instruction is available. The load is atomic, since another thread
+// may be detecting the hardware, so the compiler will not hoist it out of loops: callers with hot
+// loops check once and pick a specialized loop.
+static inline bool crc32cHasHardware() {
+#if (defined __GNUC__) || (defined __clang__)
+    int hardware = __atomic_load_n(&crc32cHardwareState, __ATOMIC_RELAXED);
+#else
+    int hardware = crc32cHardwareState;
+#endif
+    if (hardware < 0) {
+        // Called before the library was loaded, from a static constructor
+        hardware = crc32cDetectHardware();
+    }
+    return hardware != 0;
+}
+
+// Returns the unfinished CRC after the 8 bytes of word, in little endian order.
+static inline uint32_t crc32cWord(uint32_t crc, uint64_t word) {
+#if !((defined __ppc__) || (defined __ppc64__)) && (defined __LP64__)
+    if (crc32cHasHardware()) {
+        return (uint32_t) __builtin_ia32_crc32di(crc, word);
+    }
+#endif
+    return crc32cSlicingBy8(crc, &word, sizeof(word));
+}
+
+// The byte step with the tables, and with the CRC32 instruction, which requires
+// crc32cHasHardware(). crc32cByte() reloads crc32cHardwareState for every byte: loops can check
+// it once and use these directly.
+static inline uint32_t crc32cByteTable(uint32_t crc, uint8_t byte) {
+    return crc_tableil8_o32[(crc ^ byte) & 0x000000FF] ^ (crc >> 8);
+}
+
+#if !((defined __ppc__) || (defined __ppc64__))
+static inline uint32_t crc32cByteHardware(uint32_t crc, uint8_t byte) {
+    return __builtin_ia32_crc32qi(crc, byte);
+}
+#endif
+
+// Returns the unfinished CRC after byte.
+static inline uint32_t crc32cByte(uint32_t crc, uint8_t byte) {
+#if !((defined __ppc__) || (defined __ppc64__))
+    if (crc32cHasHardware()) {
+        return crc32cByteHardware(crc, byte);
+    }
+#endif
+    return crc32cByteTable(crc, byte);
+}
+
+}  // namespace logging
+
+#endif
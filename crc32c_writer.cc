@@ -0,0 +1,220 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc32c_writer.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "crc32c.h"
+#include "crc32c_internal.h"
+
+namespace logging {
+
+static const char MAGIC[8] = { 'C', 'R', 'C', '3', '2', 'C', 'W', 'T' };
+// Offset of the footer CRC, which covers the footer bytes before it
+static const size_t FOOTER_CRC_OFFSET = 28;
+static const size_t ALIGNMENT = 4096;
+
+const size_t Crc32cTrailer::FOOTER_SIZE;
+const size_t Crc32cWriter::DEFAULT_BUFFER_SIZE;
+
+// Writes all the buffers, retrying short writes.
+static bool writevFully(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t bytes = writev(fd, iov, count);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        while (count > 0 && (size_t) bytes >= iov->iov_len) {
+            bytes -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*) iov->iov_base + bytes;
+            iov->iov_len -= bytes;
+        }
+    }
+    return true;
+}
+
+bool Crc32cTrailer::read(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    uint64_t fileLength = st.st_size;
+    errno = EINVAL;
+    if (fileLength < FOOTER_SIZE) return false;
+
+    char footer[FOOTER_SIZE];
+    ssize_t bytes = preadFully(fd, footer, FOOTER_SIZE, fileLength - FOOTER_SIZE);
+    if (bytes < 0) return false;
+    errno = EINVAL;
+    if ((size_t) bytes != FOOTER_SIZE || memcmp(footer, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if (crc32cUnmask(getU32(footer + FOOTER_CRC_OFFSET)) != oneshot(footer, FOOTER_CRC_OFFSET)) {
+        return false;
+    }
+
+    uint64_t length = getU64(footer + 8);
+    uint32_t interval = getU32(footer + 16);
+    uint64_t numCheckpoints = interval == 0 ? 0 : length / interval;
+    if (fileLength - FOOTER_SIZE < length ||
+            (fileLength - FOOTER_SIZE - length) / 4 < numCheckpoints ||
+            fileLength - FOOTER_SIZE - length != 4 * numCheckpoints) {
+        return false;
+    }
+    std::vector<char> table(4 * numCheckpoints);
+    if (numCheckpoints > 0) {
+        bytes = preadFully(fd, &table[0], table.size(), length);
+        if (bytes < 0) return false;
+        errno = EINVAL;
+        if ((size_t) bytes != table.size()) return false;
+    }
+    if (crc32cUnmask(getU32(footer + 24)) != oneshot(table.data(), table.size())) return false;
+
+    dataLength = length;
+    checkpointInterval = interval;
+    crc = crc32cUnmask(getU32(footer + 20));
+    checkpoints.resize(numCheckpoints);
+    for (size_t i = 0; i < numCheckpoints; ++i) {
+        checkpoints[i] = crc32cUnmask(getU32(&table[4 * i]));
+    }
+    errno = 0;
+    return true;
+}
+
+Crc32cWriter::Crc32cWriter(int fd, uint32_t checkpointInterval, size_t bufferSize) :
+        fd_(fd), checkpointInterval_(checkpointInterval), buffer_(NULL), bufferSize_(bufferSize),
+        buffered_(0), length_(0), crc_(crc32cInit()),
+        nextCheckpoint_(checkpointInterval == 0 ? UINT64_MAX : checkpointInterval), error_(0) {
+    assert(bufferSize > 0);
+    void* buffer;
+    if (posix_memalign(&buffer, ALIGNMENT, bufferSize) != 0) abort();
+    buffer_ = (char*) buffer;
+}
+
+Crc32cWriter::~Crc32cWriter() {
+    free(buffer_);
+}
+
+uint32_t Crc32cWriter::crc() const {
+    return crc32cFinish(crc_);
+}
+
+void Crc32cWriter::checksum(const char* data, size_t length, char* destination) {
+    while (length > 0) {
+        // Stop at the next checkpoint
+        size_t pieceLength = length;
+        if (nextCheckpoint_ - length_ < pieceLength) pieceLength = nextCheckpoint_ - length_;
+        if (destination != NULL) {
+            crc_ = crc32cCopy(crc_, destination, data, pieceLength);
+            destination += pieceLength;
+        } else {
+            crc_ = crc32c(crc_, data, pieceLength);
+        }
+        data += pieceLength;
+        length -= pieceLength;
+        length_ += pieceLength;
+        if (length_ == nextCheckpoint_) {
+            checkpoints_.push_back(crc32cFinish(crc_));
+            nextCheckpoint_ += checkpointInterval_;
+        }
+    }
+}
+
+bool Crc32cWriter::writeBuffers(struct iovec* iov, int count) {
+    if (!writevFully(fd_, iov, count)) {
+        // Part of the data may have been written: the file is no longer consistent with crc_
+        error_ = errno;
+        return false;
+    }
+    return true;
+}
+
+bool Crc32cWriter::write(const void* data, size_t length) {
+    if (error_ != 0) {
+        errno = error_;
+        return false;
+    }
+    const char* p_buf = (const char*) data;
+    if (length <= bufferSize_ - buffered_) {
+        checksum(p_buf, length, buffer_ + buffered_);
+        buffered_ += length;
+        if (buffered_ == bufferSize_) return flush();
+        return true;
+    }
+
+    if (length < bufferSize_) {
+        // Fill the buffer, write it, and buffer the rest
+        size_t fill = bufferSize_ - buffered_;
+        checksum(p_buf, fill, buffer_ + buffered_);
+        buffered_ = bufferSize_;
+        if (!flush()) return false;
+        checksum(p_buf + fill, length - fill, buffer_);
+        buffered_ = length - fill;
+        return true;
+    }
+
+    // Large writes go straight from the caller's memory, with the buffer in the same system call.
+    // They are only counted once they are written.
+    struct iovec iov[2];
+    iov[0].iov_base = buffer_;
+    iov[0].iov_len = buffered_;
+    iov[1].iov_base = (void*) p_buf;
+    iov[1].iov_len = length;
+    if (!writeBuffers(iov, 2)) return false;
+    buffered_ = 0;
+    checksum(p_buf, length, NULL);
+    return true;
+}
+
+bool Crc32cWriter::flush() {
+    if (error_ != 0) {
+        errno = error_;
+        return false;
+    }
+    struct iovec iov;
+    iov.iov_base = buffer_;
+    iov.iov_len = buffered_;
+    if (!writeBuffers(&iov, 1)) return false;
+    buffered_ = 0;
+    return true;
+}
+
+bool Crc32cWriter::finish() {
+    if (error_ != 0) {
+        errno = error_;
+        return false;
+    }
+    std::vector<char> trailer(4 * checkpoints_.size() + Crc32cTrailer::FOOTER_SIZE);
+    for (size_t i = 0; i < checkpoints_.size(); ++i) {
+        putU32(&trailer[4 * i], crc32cMask(checkpoints_[i]));
+    }
+    char* footer = &trailer[4 * checkpoints_.size()];
+    memcpy(footer, MAGIC, sizeof(MAGIC));
+    putU64(footer + 8, length_);
+    putU32(footer + 16, checkpointInterval_);
+    putU32(footer + 20, crc32cMask(crc()));
+    putU32(footer + 24, crc32cMask(oneshot(&trailer[0], 4 * checkpoints_.size())));
+    putU32(footer + FOOTER_CRC_OFFSET, crc32cMask(oneshot(footer, FOOTER_CRC_OFFSET)));
+
+    // The trailer is not part of the data: append it to the buffer without checksumming it
+    struct iovec iov[2];
+    iov[0].iov_base = buffer_;
+    iov[0].iov_len = buffered_;
+    iov[1].iov_base = &trailer[0];
+    iov[1].iov_len = trailer.size();
+    if (!writeBuffers(iov, 2)) return false;
+    buffered_ = 0;
+    return true;
+}
+
+}  // namespace logging
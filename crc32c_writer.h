@@ -0,0 +1,116 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC32C_WRITER_H__
+#define LOGGING_CRC32C_WRITER_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+struct iovec;
+
+namespace logging {
+
+// The trailer written by Crc32cWriter::finish(), after the data. All integers little endian:
+//
+//   size
+//      4 * n  crc32cMask() of the finished CRC32C of data bytes [0, (i + 1) * interval), for each
+//             checkpoint i; n = data length / interval, or 0 if interval is 0
+//   footer:
+//          8  magic "CRC32CWT"
+//          8  data length in bytes
+//          4  checkpoint interval in bytes, or 0
+//          4  crc32cMask() of the finished CRC32C of the data
+//          4  crc32cMask() of the finished CRC32C of the checkpoint table
+//          4  crc32cMask() of the finished CRC32C of the footer bytes before this field
+struct Crc32cTrailer {
+    static const size_t FOOTER_SIZE = 32;
+
+    uint64_t dataLength;
+    uint32_t checkpointInterval;
+    uint32_t crc;
+    // Finished CRCs of each prefix of the data that is a multiple of checkpointInterval long
+    std::vector<uint32_t> checkpoints;
+
+    // Returns the total size of the trailer in bytes.
+    size_t size() const { return 4 * checkpoints.size() + FOOTER_SIZE; }
+
+    // Reads the trailer at the end of the file fd. Returns false and sets errno on error, or to
+    // EINVAL if the trailer is missing or corrupt.
+    bool read(int fd);
+};
+
+// Buffers writes to a file descriptor, computing the CRC32C of the data as it is copied into the
+// buffer, while it is in cache. Without this, writers copy data into a buffer, checksum the
+// buffer, then write it: the data is read three times instead of once. The buffer is written
+// with a single system call when it is full, or together with large writes using writev. Writes
+// larger than the buffer are not copied.
+//
+// Every checkpointInterval bytes, the CRC of the data so far is recorded. finish() appends the
+// CRC and the checkpoints to the data as a Crc32cTrailer, so a reader can verify a truncated
+// stream up to its last checkpoint.
+//
+// Methods return false and set errno on error. After a failed write, the file no longer holds
+// the data the CRC describes, so every later write(), flush() and finish() fails with the same
+// errno.
+class Crc32cWriter {
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    // Writes to fd, which is not closed by the writer. fd must not use O_DIRECT: large writes are
+    // passed to the kernel from the caller's buffers, which need not be aligned, and the trailer
+    // is not padded.
+    explicit Crc32cWriter(int fd, uint32_t checkpointInterval = 0,
+            size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    // Buffered data that was not flushed is lost.
+    ~Crc32cWriter();
+
+    bool write(const void* data, size_t length);
+
+    // Writes the buffered data.
+    bool flush();
+
+    // Writes the trailer and flushes. Further writes are not allowed.
+    bool finish();
+
+    // Returns the number of data bytes written, not including the trailer.
+    uint64_t length() const { return length_; }
+
+    // Returns the finished CRC of the data written so far.
+    uint32_t crc() const;
+
+    // Returns the finished CRCs of each prefix of the data that is a multiple of the checkpoint
+    // interval long.
+    const std::vector<uint32_t>& checkpoints() const { return checkpoints_; }
+
+private:
+    // Not copyable
+    Crc32cWriter(const Crc32cWriter&);
+    Crc32cWriter& operator=(const Crc32cWriter&);
+
+    // Adds length bytes at data to the CRC and records checkpoints. If destination is not NULL,
+    // also copies the bytes there.
+    void checksum(const char* data, size_t length, char* destination);
+
+    // Writes the buffers, or records the error so the writer stays failed.
+    bool writeBuffers(struct iovec* iov, int count);
+
+    int fd_;
+    uint32_t checkpointInterval_;
+    char* buffer_;
+    size_t bufferSize_;
+    size_t buffered_;
+    uint64_t length_;
+    // Unfinished CRC of all data
+    uint32_t crc_;
+    uint64_t nextCheckpoint_;
+    std::vector<uint32_t> checkpoints_;
+    // errno of the first failed write, or 0
+    int error_;
+};
+
+}  // namespace logging
+
+#endif
@@ -0,0 +1,265 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "crc_engine.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "crc32c.h"
+
+#if (defined __x86_64__) && ((defined __GNUC__) || (defined __clang__))
+#define CRC_ENGINE_FOLDING
+#include <immintrin.h>
+#endif
+
+namespace logging {
+
+const size_t CrcEngine::FOLD_MIN_LENGTH;
+
+static const uint64_t CASTAGNOLI = 0x82f63b78;
+
+static uint64_t loadU64(const char* p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+#if (defined __BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+#ifdef CRC_ENGINE_FOLDING
+// Returns lane * x^d mod P(x) as a 128 bit polynomial, where constants holds
+// x^(d + 64) mod P(x) in the low half and x^d mod P(x) in the high half. The low half of a lane
+// holds its 64 highest degree terms.
+__attribute__((target("pclmul,sse4.2")))
+static inline __m128i foldLane(__m128i lane, __m128i constants) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(lane, constants, 0x00),
+            _mm_clmulepi64_si128(lane, constants, 0x11));
+}
+
+// Adds length bytes at p, a multiple of 8, to the CRC32C register crc with the CRC32 instruction.
+__attribute__((target("sse4.2")))
+static inline uint32_t crc32cBlock(uint32_t crc, const char* p, size_t length) {
+    uint64_t crc64 = crc;
+    for (size_t i = 0; i < length; i += 8) {
+        crc64 = __builtin_ia32_crc32di(crc64, loadU64(p + i));
+    }
+    return (uint32_t) crc64;
+}
+
+// Folds length bytes at p, at least 64, with the register crc into one 16 byte lane, which has
+// the same CRC from a zero register as the bytes that were folded. Stores the lane to out and
+// returns the number of bytes folded, a multiple of 16. With Castagnoli, also adds the folded
+// bytes to the CRC32C register *crcC with the CRC32 instruction, which runs in parallel with the
+// multiplications and reuses the loaded lines.
+template <bool Castagnoli>
+__attribute__((target("pclmul,sse4.2")))
+static size_t foldKernel(const uint64_t fold512[2], const uint64_t fold384[2],
+        const uint64_t fold256[2], const uint64_t fold128[2], uint64_t crc, const char* p,
+        size_t length, char out[16], uint32_t* crcC) {
+    uint32_t castagnoli = Castagnoli ? crc32cBlock(*crcC, p, 64) : 0;
+    __m128i k512 = _mm_set_epi64x((long long) fold512[1], (long long) fold512[0]);
+    __m128i k128 = _mm_set_epi64x((long long) fold128[1], (long long) fold128[0]);
+    // The register is added to the first bytes of the message
+    __m128i x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i*) p),
+            _mm_cvtsi64_si128((long long) crc));
+    __m128i x1 = _mm_loadu_si128((const __m128i*) (p + 16));
+    __m128i x2 = _mm_loadu_si128((const __m128i*) (p + 32));
+    __m128i x3 = _mm_loadu_si128((const __m128i*) (p + 48));
+    size_t i = 64;
+    for (; i + 64 <= length; i += 64) {
+        if (Castagnoli) castagnoli = crc32cBlock(castagnoli, p + i, 64);
+        x0 = _mm_xor_si128(foldLane(x0, k512), _mm_loadu_si128((const __m128i*) (p + i)));
+        x1 = _mm_xor_si128(foldLane(x1, k512), _mm_loadu_si128((const __m128i*) (p + i + 16)));
+        x2 = _mm_xor_si128(foldLane(x2, k512), _mm_loadu_si128((const __m128i*) (p + i + 32)));
+        x3 = _mm_xor_si128(foldLane(x3, k512), _mm_loadu_si128((const __m128i*) (p + i + 48)));
+    }
+
+    __m128i k384 = _mm_set_epi64x((long long) fold384[1], (long long) fold384[0]);
+    __m128i k256 = _mm_set_epi64x((long long) fold256[1], (long long) fold256[0]);
+    __m128i x = _mm_xor_si128(foldLane(x0, k384), foldLane(x1, k256));
+    x = _mm_xor_si128(x, foldLane(x2, k128));
+    x = _mm_xor_si128(x, x3);
+    for (; i + 16 <= length; i += 16) {
+        if (Castagnoli) castagnoli = crc32cBlock(castagnoli, p + i, 16);
+        x = _mm_xor_si128(foldLane(x, k128), _mm_loadu_si128((const __m128i*) (p + i)));
+    }
+    _mm_storeu_si128((__m128i*) out, x);
+    if (Castagnoli) *crcC = castagnoli;
+    return i;
+}
+#endif
+
+CrcEngine::CrcEngine(int width, uint64_t reversedPolynomial) :
+        width_(width), polynomial_(reversedPolynomial),
+        mask_(width == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << width) - 1),
+        castagnoli_(width == 32 && reversedPolynomial == CASTAGNOLI), folding_(false) {
+    assert(width >= 8 && width <= 64);
+    for (int b = 0; b < 256; ++b) {
+        uint64_t crc = b;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ polynomial_ : crc >> 1;
+        }
+        tables_[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (int b = 0; b < 256; ++b) {
+            uint64_t previous = tables_[k - 1][b];
+            tables_[k][b] = (previous >> 8) ^ tables_[0][previous & 0xff];
+        }
+    }
+
+    shiftTable_[0] = powerOfX(8);
+    for (int i = 1; i < 64; ++i) {
+        shiftTable_[i] = multiply(shiftTable_[i - 1], shiftTable_[i - 1]);
+    }
+
+    static const uint64_t DISTANCES[] = { 512, 384, 256, 128 };
+    uint64_t* constants[] = { fold512_, fold384_, fold256_, fold128_ };
+    for (int i = 0; i < 4; ++i) {
+        constants[i][0] = foldConstant(DISTANCES[i] + 64);
+        constants[i][1] = foldConstant(DISTANCES[i]);
+    }
+#ifdef CRC_ENGINE_FOLDING
+    folding_ = __builtin_cpu_supports("pclmul");
+#endif
+}
+
+const CrcEngine& CrcEngine::crc32() {
+    static const CrcEngine engine(32, 0xedb88320);
+    return engine;
+}
+
+const CrcEngine& CrcEngine::crc32c() {
+    static const CrcEngine engine(32, CASTAGNOLI);
+    return engine;
+}
+
+const CrcEngine& CrcEngine::crc64Xz() {
+    static const CrcEngine engine(64, 0xc96c5795d7870f42ULL);
+    return engine;
+}
+
+const CrcEngine& CrcEngine::crc64Nvme() {
+    static const CrcEngine engine(64, 0x9a6c9329ac4bc9b5ULL);
+    return engine;
+}
+
+uint64_t CrcEngine::multiply(uint64_t a, uint64_t b) const {
+    // In the reflected bit order the high bit is x^0, and multiplying by x is a right shift
+    uint64_t top = (uint64_t) 1 << (width_ - 1);
+    uint64_t product = 0;
+    while (a != 0) {
+        if (a & top) {
+            product ^= b;
+        }
+        a = (a << 1) & mask_;
+        b = (b & 1) ? (b >> 1) ^ polynomial_ : b >> 1;
+    }
+    return product;
+}
+
+uint64_t CrcEngine::powerOfX(uint64_t k) const {
+    uint64_t power = (uint64_t) 1 << (width_ - 1);
+    for (uint64_t i = 0; i < k; ++i) {
+        power = (power & 1) ? (power >> 1) ^ polynomial_ : power >> 1;
+    }
+    return power;
+}
+
+uint64_t CrcEngine::foldConstant(uint64_t k) const {
+    // A carry-less product of two reflected 64 bit values lands one bit short of the reflected
+    // 128 bit layout. Using x^(k - 1) mod P(x), aligned as 64 bits, makes up for it.
+    return powerOfX(k - 1) << (64 - width_);
+}
+
+uint64_t CrcEngine::update(uint64_t crc, const void* data, size_t length) const {
+    if (castagnoli_) {
+        return logging::crc32c((uint32_t) crc, data, length);
+    }
+    if (folding_ && length >= FOLD_MIN_LENGTH) {
+        return updateFolding(crc, data, length);
+    }
+    return updateSlicing(crc, data, length);
+}
+
+uint64_t CrcEngine::updateSlicing(uint64_t crc, const void* data, size_t length) const {
+    const char* p_buf = (const char*) data;
+    for (; length >= 8; length -= 8, p_buf += 8) {
+        uint64_t word = loadU64(p_buf) ^ crc;
+        crc = tables_[7][word & 0xff] ^
+                tables_[6][(word >> 8) & 0xff] ^
+                tables_[5][(word >> 16) & 0xff] ^
+                tables_[4][(word >> 24) & 0xff] ^
+                tables_[3][(word >> 32) & 0xff] ^
+                tables_[2][(word >> 40) & 0xff] ^
+                tables_[1][(word >> 48) & 0xff] ^
+                tables_[0][word >> 56];
+    }
+    for (; length > 0; --length, ++p_buf) {
+        crc = tables_[0][(crc ^ (uint8_t) *p_buf) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint64_t CrcEngine::updateFolding(uint64_t crc, const void* data, size_t length) const {
+#ifdef CRC_ENGINE_FOLDING
+    assert(folding_ && length >= FOLD_MIN_LENGTH);
+    const char* p_buf = (const char*) data;
+    char lane[16];
+    size_t folded = foldKernel<false>(fold512_, fold384_, fold256_, fold128_, crc, p_buf, length,
+            lane, NULL);
+    crc = updateSlicing(0, lane, sizeof(lane));
+    return updateSlicing(crc, p_buf + folded, length - folded);
+#else
+    // Not compiled in: hasFolding() is false, and this is the same as updateSlicing()
+    return updateSlicing(crc, data, length);
+#endif
+}
+
+void CrcEngine::updateCrc32cAndCrc32(uint32_t* crcC, uint32_t* crcIeee, const void* data,
+        size_t length) {
+    const CrcEngine& ieee = crc32();
+    const char* p_buf = (const char*) data;
+#ifdef CRC_ENGINE_FOLDING
+    if (ieee.folding_ && length >= FOLD_MIN_LENGTH && __builtin_cpu_supports("sse4.2")) {
+        char lane[16];
+        size_t folded = foldKernel<true>(ieee.fold512_, ieee.fold384_, ieee.fold256_,
+                ieee.fold128_, *crcIeee, p_buf, length, lane, crcC);
+        *crcIeee = (uint32_t) ieee.updateSlicing(0, lane, sizeof(lane));
+        p_buf += folded;
+        length -= folded;
+    }
+#endif
+    // Short buffers and the tail
+    *crcC = logging::crc32c(*crcC, p_buf, length);
+    *crcIeee = (uint32_t) ieee.updateSlicing(*crcIeee, p_buf, length);
+}
+
+uint64_t CrcEngine::shiftOperator(uint64_t length) const {
+    if (castagnoli_) {
+        return crc32cShiftOperator((size_t) length);
+    }
+    uint64_t op = (uint64_t) 1 << (width_ - 1);
+    for (int i = 0; length != 0; ++i, length >>= 1) {
+        if (length & 1) {
+            op = multiply(op, shiftTable_[i]);
+        }
+    }
+    return op;
+}
+
+uint64_t CrcEngine::shift(uint64_t crc, uint64_t op) const {
+    if (castagnoli_) {
+        return crc32cShift((uint32_t) crc, (uint32_t) op);
+    }
+    return multiply(op, crc);
+}
+
+uint64_t CrcEngine::combine(uint64_t crcA, uint64_t crcB, uint64_t lengthB) const {
+    return shift(crcA, shiftOperator(lengthB)) ^ crcB;
+}
+
+}  // namespace logging
@@ -0,0 +1,115 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef LOGGING_CRC_ENGINE_H__
+#define LOGGING_CRC_ENGINE_H__
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace logging {
+
+// A reflected CRC of 8 to 64 bits for any polynomial, such as the CRC-32 of zlib and gzip or the
+// CRC-64 of xz, with the same kernels and arithmetic that crc32c.c has for CRC32C. The register
+// starts as all ones and is finished by inverting it, as for CRC32C, and CRC values are held in
+// the low bits of a uint64_t.
+//
+// The tables and constants are generated for the polynomial by the constructor:
+//   - slicing-by-8 tables, for short buffers and CPUs without PCLMULQDQ
+//   - PCLMULQDQ folding constants x^k mod P(x), for buffers of 64 bytes or more: four 16 byte
+//     lanes are folded forward with carry-less multiplications, then the last lane and the tail
+//     are finished with the tables
+//   - x^(8 * 2^i) mod P(x), for shifting and combining CRCs in O(log length)
+//
+// The CRC32C engine passes updates to crc32c() and combines to crc32cShift(), so it keeps the
+// CRC32 instruction fast path.
+class CrcEngine {
+public:
+    // A CRC of width bits with the bit-reversed polynomial reversedPolynomial, which excludes
+    // the x^width term: 0xedb88320 for CRC-32.
+    CrcEngine(int width, uint64_t reversedPolynomial);
+
+    // CRC-32 of IEEE 802.3, zlib, gzip and PNG.
+    static const CrcEngine& crc32();
+    // CRC-32C (Castagnoli), the same as crc32c().
+    static const CrcEngine& crc32c();
+    // CRC-64 of ECMA-182 as used by xz.
+    static const CrcEngine& crc64Xz();
+    // CRC-64 of NVMe.
+    static const CrcEngine& crc64Nvme();
+
+    int width() const { return width_; }
+    uint64_t reversedPolynomial() const { return polynomial_; }
+
+    // Returns the initial value of the register.
+    uint64_t init() const { return mask_; }
+    // Converts an unfinished CRC to the final value, and back.
+    uint64_t finish(uint64_t crc) const { return crc ^ mask_; }
+
+    // Returns the unfinished CRC after length more bytes at data.
+    uint64_t update(uint64_t crc, const void* data, size_t length) const;
+    // Returns the finished CRC of length bytes at data.
+    uint64_t checksum(const void* data, size_t length) const {
+        return finish(update(init(), data, length));
+    }
+
+    // Returns an operator for shift() that appends length zero bytes: x^(8 * length) mod P(x).
+    uint64_t shiftOperator(uint64_t length) const;
+    // Multiplies crc by op, from shiftOperator(). For an unfinished CRC this appends the zero
+    // bytes; for finished CRCs, combine(crcA, crcB, lengthB) is
+    // shift(crcA, shiftOperator(lengthB)) ^ crcB.
+    uint64_t shift(uint64_t crc, uint64_t op) const;
+    // Returns the finished CRC of A||B, given the finished CRCs of A and B.
+    uint64_t combine(uint64_t crcA, uint64_t crcB, uint64_t lengthB) const;
+
+    // Updates the unfinished CRC32C *crcC and the unfinished CRC-32 *crcIeee with length bytes at
+    // data, reading the data once: the CRC32 instruction computes the CRC32C while the same
+    // loads are folded for the CRC-32. Cheaper than crc32c() and crc32().update() when the data
+    // is not in the cache.
+    static void updateCrc32cAndCrc32(uint32_t* crcC, uint32_t* crcIeee, const void* data,
+            size_t length);
+
+    // Returns true if update() uses PCLMULQDQ folding for long buffers.
+    bool hasFolding() const { return folding_; }
+
+    // The generic kernels, for testing. updateFolding() requires at least FOLD_MIN_LENGTH bytes,
+    // and hasFolding() on builds for x86-64; on other targets folding is not compiled in and it
+    // is the same as updateSlicing().
+    static const size_t FOLD_MIN_LENGTH = 64;
+    uint64_t updateSlicing(uint64_t crc, const void* data, size_t length) const;
+    uint64_t updateFolding(uint64_t crc, const void* data, size_t length) const;
+
+private:
+    // Returns a(x) * b(x) mod P(x).
+    uint64_t multiply(uint64_t a, uint64_t b) const;
+    // Returns x^k mod P(x), one bit at a time: for the small exponents of the fold constants.
+    uint64_t powerOfX(uint64_t k) const;
+    // Returns x^k mod P(x) in the layout of the folding kernel.
+    uint64_t foldConstant(uint64_t k) const;
+
+    int width_;
+    uint64_t polynomial_;
+    uint64_t mask_;
+    // Uses the crc32c.c kernels
+    bool castagnoli_;
+    bool folding_;
+    // tables_[k][b] is the CRC, from a zero register, of byte b followed by k zero bytes
+    uint64_t tables_[8][256];
+    // x^(8 * 2^i) mod P(x)
+    uint64_t shiftTable_[64];
+    // Pairs of constants for folding a lane forward by 512 bits (the main loop), and by 384, 256
+    // and 128 bits (the last lanes into the final one)
+    uint64_t fold512_[2];
+    uint64_t fold384_[2];
+    uint64_t fold256_[2];
+    uint64_t fold128_[2];
+
+    // No copying: the engines are large
+    CrcEngine(const CrcEngine&);
+    CrcEngine& operator=(const CrcEngine&);
+};
+
+}  // namespace logging
+
+#endif
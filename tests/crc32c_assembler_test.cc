@@ -0,0 +1,112 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_assembler.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+struct Segment {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Splits length bytes into segments of varying lengths, in shuffled order.
+static std::vector<Segment> makeSegments(size_t length, uint32_t seed) {
+    std::vector<Segment> segments;
+    uint32_t x = seed;
+    for (size_t offset = 0; offset < length; ) {
+        x = x * 1103515245 + 12345;
+        Segment segment = { offset, std::min((size_t) (x >> 16) % 5000 + 1, length - offset) };
+        segments.push_back(segment);
+        offset += segment.length;
+    }
+    for (size_t i = segments.size() - 1; i > 0; --i) {
+        x = x * 1103515245 + 12345;
+        std::swap(segments[i], segments[(x >> 8) % (i + 1)]);
+    }
+    return segments;
+}
+
+TEST(Crc32cAssembler, OutOfOrder) {
+    std::vector<char> data = makeData(1000000);
+    std::vector<Segment> segments = makeSegments(data.size(), 1);
+    Crc32cAssembler assembler(data.size());
+    uint32_t crc;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        EXPECT_FALSE(assembler.crc(&crc));
+        const Segment& segment = segments[i];
+        ASSERT_TRUE(assembler.add(segment.offset, segment.length,
+                oneshot(&data[segment.offset], segment.length)));
+    }
+    EXPECT_TRUE(assembler.complete());
+    EXPECT_EQ(1, assembler.numRuns());
+    EXPECT_EQ(data.size(), assembler.coveredLength());
+    ASSERT_TRUE(assembler.crc(&crc));
+    EXPECT_EQ(oneshot(&data[0], data.size()), crc);
+    EXPECT_EQ(crc, assembler.wait());
+}
+
+TEST(Crc32cAssembler, Invalid) {
+    Crc32cAssembler assembler(100);
+    EXPECT_TRUE(assembler.add(10, 20, 0x1234));
+    EXPECT_TRUE(assembler.add(50, 10, 0x5678));
+    // Overlaps, at either end or inside
+    EXPECT_FALSE(assembler.add(0, 11, 0));
+    EXPECT_FALSE(assembler.add(29, 2, 0));
+    EXPECT_FALSE(assembler.add(15, 1, 0));
+    EXPECT_FALSE(assembler.add(0, 100, 0));
+    // Past the end
+    EXPECT_FALSE(assembler.add(90, 11, 0));
+    EXPECT_FALSE(assembler.add(101, 0, 0));
+    EXPECT_EQ(30, assembler.coveredLength());
+    EXPECT_EQ(2, assembler.numRuns());
+    EXPECT_TRUE(assembler.add(30, 20, 0));
+    EXPECT_EQ(1, assembler.numRuns());
+
+    // An empty object is complete at once
+    Crc32cAssembler empty(0);
+    uint32_t crc = 1;
+    EXPECT_TRUE(empty.crc(&crc));
+    EXPECT_EQ(0, crc);
+}
+
+static void addSegments(Crc32cAssembler* assembler, const std::vector<char>* data,
+        const std::vector<Segment>* segments, size_t first, size_t step) {
+    for (size_t i = first; i < segments->size(); i += step) {
+        const Segment& segment = (*segments)[i];
+        assembler->add(segment.offset, segment.length,
+                oneshot(&(*data)[segment.offset], segment.length));
+    }
+}
+
+TEST(Crc32cAssembler, Threads) {
+    std::vector<char> data = makeData(2000000);
+    std::vector<Segment> segments = makeSegments(data.size(), 2);
+    Crc32cAssembler assembler(data.size());
+    uint32_t crc = 0;
+    std::thread waiter([&assembler, &crc]() { crc = assembler.wait(); });
+
+    static const size_t NUM_THREADS = 4;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        threads.push_back(std::thread(addSegments, &assembler, &data, &segments, i,
+                NUM_THREADS));
+    }
+    for (size_t i = 0; i < NUM_THREADS; ++i) {
+        threads[i].join();
+    }
+    waiter.join();
+    EXPECT_EQ(oneshot(&data[0], data.size()), crc);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
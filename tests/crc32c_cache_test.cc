@@ -0,0 +1,187 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_cache.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static void writeFile(const char* path, const char* contents) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    write(fd, contents, strlen(contents));
+    close(fd);
+}
+
+static uint32_t oneshot(const char* data) {
+    return crc32cFinish(crc32c(crc32cInit(), data, strlen(data)));
+}
+
+// Checksums path with the cache; returns true on a hit.
+static bool checksum(const char* path, Crc32cCache* cache, uint32_t* crc) {
+    int fd = open(path, O_RDONLY);
+    bool hit;
+    bool success = crc32cFileCached(fd, cache, crc, &hit);
+    close(fd);
+    return success && hit;
+}
+
+// Returns a stat for a file that does not exist, old enough not to be racy.
+static struct stat fakeStat(uint64_t inode) {
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    st.st_dev = 1;
+    st.st_ino = inode;
+    st.st_size = inode * 3;
+    st.st_mtim.tv_sec = 1000000000;
+    st.st_ctim.tv_sec = 1000000000 + inode;
+    return st;
+}
+
+TEST(Crc32cCache, HitAndMiss) {
+    stupidunit::ChTempDir temp;
+    writeFile("data", "hello world");
+    {
+        Crc32cCache cache(0);
+        ASSERT_TRUE(cache.open("cache"));
+        uint32_t crc;
+        EXPECT_FALSE(checksum("data", &cache, &crc));
+        EXPECT_EQ(oneshot("hello world"), crc);
+        EXPECT_TRUE(checksum("data", &cache, &crc));
+        EXPECT_EQ(oneshot("hello world"), crc);
+    }
+
+    // Persistent
+    Crc32cCache cache(0);
+    ASSERT_TRUE(cache.open("cache"));
+    uint32_t crc = 0;
+    EXPECT_TRUE(checksum("data", &cache, &crc));
+    EXPECT_EQ(oneshot("hello world"), crc);
+
+    // Any change to the file is a miss: the ctime changes even if the size does not
+    writeFile("data", "HELLO WORLD");
+    EXPECT_FALSE(checksum("data", &cache, &crc));
+    EXPECT_EQ(oneshot("HELLO WORLD"), crc);
+    EXPECT_TRUE(checksum("data", &cache, &crc));
+    EXPECT_EQ(oneshot("HELLO WORLD"), crc);
+}
+
+TEST(Crc32cCache, Racy) {
+    stupidunit::ChTempDir temp;
+    writeFile("data", "hello world");
+    // The file was just written: it is not cached
+    Crc32cCache cache;
+    ASSERT_TRUE(cache.open("cache"));
+    uint32_t crc;
+    EXPECT_FALSE(checksum("data", &cache, &crc));
+    EXPECT_FALSE(checksum("data", &cache, &crc));
+    EXPECT_EQ(oneshot("hello world"), crc);
+
+    struct stat st = fakeStat(5);
+    EXPECT_TRUE(cache.insert(st, 1234));
+    EXPECT_TRUE(cache.lookup(st, &crc));
+    EXPECT_EQ(1234, crc);
+}
+
+TEST(Crc32cCache, Eviction) {
+    stupidunit::ChTempDir temp;
+    Crc32cCache cache(0);
+    ASSERT_TRUE(cache.open("cache", 64));
+    EXPECT_EQ(64, cache.numSlots());
+    // Many more files than slots: the most recent is always present
+    for (uint64_t inode = 1; inode < 1000; ++inode) {
+        struct stat st = fakeStat(inode);
+        EXPECT_TRUE(cache.insert(st, (uint32_t) inode * 7));
+        uint32_t crc;
+        ASSERT_TRUE(cache.lookup(st, &crc));
+        EXPECT_EQ(inode * 7, crc);
+    }
+
+    // The slot count of an existing cache wins
+    Crc32cCache other(0);
+    ASSERT_TRUE(other.open("cache", 1024));
+    EXPECT_EQ(64, other.numSlots());
+}
+
+TEST(Crc32cCache, Corruption) {
+    stupidunit::ChTempDir temp;
+    {
+        Crc32cCache cache(0);
+        ASSERT_TRUE(cache.open("cache", 64));
+        for (uint64_t inode = 1; inode < 10; ++inode) {
+            cache.insert(fakeStat(inode), 100);
+        }
+    }
+
+    // Damaged entries are misses
+    int fd = open("cache", O_RDWR);
+    std::vector<char> garbage(64 * 48, 0x55);
+    ASSERT_EQ(garbage.size(), pwrite(fd, &garbage[0], garbage.size(), 64));
+    Crc32cCache cache(0);
+    ASSERT_TRUE(cache.open("cache", 64));
+    uint32_t crc;
+    for (uint64_t inode = 1; inode < 10; ++inode) {
+        EXPECT_FALSE(cache.lookup(fakeStat(inode), &crc));
+    }
+    EXPECT_TRUE(cache.insert(fakeStat(1), 100));
+    EXPECT_TRUE(cache.lookup(fakeStat(1), &crc));
+
+    // A damaged header recreates the cache as a new file: the old mapping stays readable
+    ASSERT_EQ(1, pwrite(fd, "X", 1, 0));
+    close(fd);
+    Crc32cCache recreated(0);
+    ASSERT_TRUE(recreated.open("cache", 32));
+    EXPECT_EQ(32, recreated.numSlots());
+    EXPECT_FALSE(recreated.lookup(fakeStat(1), &crc));
+    EXPECT_TRUE(cache.lookup(fakeStat(1), &crc));
+    EXPECT_TRUE(recreated.insert(fakeStat(2), 200));
+    Crc32cCache reopened(0);
+    ASSERT_TRUE(reopened.open("cache", 128));
+    EXPECT_EQ(32, reopened.numSlots());
+    EXPECT_TRUE(reopened.lookup(fakeStat(2), &crc));
+    EXPECT_EQ(200, crc);
+}
+
+static void insertAndLookup(int thread, int* failures) {
+    Crc32cCache cache(0);
+    if (!cache.open("cache", 4096)) {
+        *failures += 1;
+        return;
+    }
+    for (int round = 0; round < 20; ++round) {
+        for (uint64_t inode = 1; inode < 200; ++inode) {
+            struct stat st = fakeStat(inode + 1000 * thread);
+            cache.insert(st, (uint32_t) st.st_ino);
+            uint32_t crc;
+            // Entries may be evicted by other threads, but never wrong
+            if (cache.lookup(st, &crc) && crc != st.st_ino) *failures += 1;
+        }
+    }
+}
+
+TEST(Crc32cCache, Concurrent) {
+    stupidunit::ChTempDir temp;
+    // Each thread opens the cache separately, like separate processes
+    static const int NUM_THREADS = 4;
+    std::vector<std::thread> threads;
+    int failures[NUM_THREADS] = { 0 };
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.push_back(std::thread(insertAndLookup, i, &failures[i]));
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads[i].join();
+        EXPECT_EQ(0, failures[i]);
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,71 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_checksummed_buffer.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static uint32_t directCrc(const ChecksummedBuffer& buffer) {
+    return crc32cFinish(crc32c(crc32cInit(), buffer.data(), buffer.length()));
+}
+
+TEST(ChecksummedBuffer, Empty) {
+    ChecksummedBuffer buffer(0, 4096);
+    EXPECT_EQ(0, buffer.crc());
+    EXPECT_EQ(0, buffer.numDirtyBlocks());
+}
+
+TEST(ChecksummedBuffer, Initial) {
+    static const size_t LENGTHS[] = { 1, 4095, 4096, 4097, 100000 };
+    for (size_t i = 0; i < sizeof(LENGTHS)/sizeof(*LENGTHS); ++i) {
+        ChecksummedBuffer buffer(LENGTHS[i], 4096);
+        EXPECT_EQ((LENGTHS[i] + 4095) / 4096, buffer.numDirtyBlocks());
+        EXPECT_EQ(directCrc(buffer), buffer.crc());
+        EXPECT_EQ(0, buffer.numDirtyBlocks());
+    }
+}
+
+TEST(ChecksummedBuffer, Writes) {
+    static const size_t BLOCK_SIZE = 512;
+    // The last block is short
+    ChecksummedBuffer buffer(100 * BLOCK_SIZE + 100, BLOCK_SIZE);
+    buffer.crc();
+
+    uint32_t x = 1;
+    for (int trial = 0; trial < 200; ++trial) {
+        // A few small writes between each check
+        for (int write = 0; write < 3; ++write) {
+            x = x * 1103515245 + 12345;
+            size_t offset = (x >> 8) % buffer.length();
+            size_t length = std::min((size_t) (x % 16), buffer.length() - offset);
+            char bytes[16];
+            for (size_t i = 0; i < length; ++i) bytes[i] = (char) (x >> i);
+            buffer.write(offset, bytes, length);
+        }
+        EXPECT_LE(buffer.numDirtyBlocks(), 6);
+        EXPECT_EQ(directCrc(buffer), buffer.crc());
+    }
+
+    // Write through a pointer, including the short last block
+    char* p = buffer.mutableData(buffer.length() - 150, 150);
+    for (int i = 0; i < 150; ++i) p[i] = (char) i;
+    EXPECT_EQ(2, buffer.numDirtyBlocks());
+    EXPECT_EQ(directCrc(buffer), buffer.crc());
+
+    // Marking clean data dirty does not change the CRC
+    uint32_t crc = buffer.crc();
+    buffer.markDirty(0, buffer.length());
+    EXPECT_EQ(101, buffer.numDirtyBlocks());
+    EXPECT_EQ(crc, buffer.crc());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,84 @@
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_chunker.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+static const size_t BUFFER_SIZE = 16 << 20;
+
+struct ChunkSizes {
+    size_t minSize;
+    size_t avgSize;
+    size_t maxSize;
+};
+
+static const ChunkSizes SIZES[] = {
+    { 2048, 8192, 65536 },
+    { 16384, 65536, 262144 },
+};
+
+static void runChunker(const ChunkSizes& sizes, const std::vector<char>& buffer) {
+    printf("Crc32cChunker,%zu,%zu", sizes.avgSize, buffer.size());
+    std::vector<Crc32cChunk> chunks;
+    chunks.reserve(buffer.size() / sizes.minSize + 1);
+    for (int j = 0; j < TRIALS; ++j) {
+        Crc32cChunker chunker(sizes.minSize, sizes.avgSize, sizes.maxSize);
+        chunks.clear();
+        CycleTimer timer;
+        timer.start();
+        chunker.update(&buffer[0], buffer.size(), &chunks);
+        Crc32cChunk last;
+        if (chunker.finish(&last)) chunks.push_back(last);
+        timer.end();
+        printf(",%d", timer.getCycles());
+    }
+    printf(",%zu\n", chunks.size());
+}
+
+static void runFixed(CRC32CFunctionPtr crcfn, const char* name, size_t chunkSize,
+        const std::vector<char>& buffer) {
+    printf("%s,%zu,%zu", name, chunkSize, buffer.size());
+    std::vector<Crc32cChunk> chunks;
+    chunks.reserve(buffer.size() / chunkSize + 1);
+    for (int j = 0; j < TRIALS; ++j) {
+        chunks.clear();
+        CycleTimer timer;
+        timer.start();
+        for (size_t offset = 0; offset < buffer.size(); offset += chunkSize) {
+            Crc32cChunk chunk;
+            chunk.offset = offset;
+            chunk.length = std::min(chunkSize, buffer.size() - offset);
+            chunk.crc = crc32cFinish(crcfn(crc32cInit(), &buffer[offset], chunk.length));
+            chunks.push_back(chunk);
+        }
+        timer.end();
+        printf(",%d", timer.getCycles());
+    }
+    printf(",%zu\n", chunks.size());
+}
+
+int main() {
+    std::vector<char> buffer(BUFFER_SIZE);
+    uint32_t x = 1;
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        x = x * 1103515245 + 12345;
+        buffer[i] = (char) (x >> 16);
+    }
+
+    bool hasHardware = (detectBestCRC32C() != crc32cSlicingBy8);
+    printf("function,avgsize,bytes,cycles,cycles,cycles,cycles,cycles,chunks\n");
+    for (size_t i = 0; i < sizeof(SIZES)/sizeof(*SIZES); ++i) {
+        runChunker(SIZES[i], buffer);
+        if (hasHardware) {
+            runFixed(crc32cHardware64, "fixed/crc32cHardware64", SIZES[i].avgSize, buffer);
+        } else {
+            runFixed(crc32cSlicingBy8, "fixed/crc32cSlicingBy8", SIZES[i].avgSize, buffer);
+        }
+    }
+    return 0;
+}
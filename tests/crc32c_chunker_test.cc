@@ -0,0 +1,123 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+#include "crc32c_chunker.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static const size_t MIN_SIZE = 512;
+static const size_t AVG_SIZE = 2048;
+static const size_t MAX_SIZE = 8192;
+
+// Chunks data, passing it to update() in pieces of at most step bytes.
+static std::vector<Crc32cChunk> chunkAll(const std::vector<char>& data, size_t step) {
+    Crc32cChunker chunker(MIN_SIZE, AVG_SIZE, MAX_SIZE);
+    std::vector<Crc32cChunk> chunks;
+    for (size_t offset = 0; offset < data.size(); offset += step) {
+        chunker.update(&data[offset], std::min(step, data.size() - offset), &chunks);
+    }
+    Crc32cChunk last;
+    if (chunker.finish(&last)) chunks.push_back(last);
+    return chunks;
+}
+
+static bool sameChunks(const std::vector<Crc32cChunk>& a, const std::vector<Crc32cChunk>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].offset != b[i].offset || a[i].length != b[i].length || a[i].crc != b[i].crc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks that chunks exactly cover data, respect the size limits and have the right CRCs.
+static bool validChunks(const std::vector<char>& data, const std::vector<Crc32cChunk>& chunks) {
+    uint64_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const Crc32cChunk& chunk = chunks[i];
+        if (chunk.offset != offset) return false;
+        if (chunk.length > MAX_SIZE) return false;
+        if (chunk.length < MIN_SIZE && i != chunks.size() - 1) return false;
+        uint32_t crc = oneshot(&data[offset], chunk.length);
+        if (crc != chunk.crc) return false;
+        offset += chunk.length;
+    }
+    return offset == data.size();
+}
+
+TEST(Crc32cChunker, Chunks) {
+    std::vector<char> data = makeData(1 << 20, 1);
+    std::vector<Crc32cChunk> chunks = chunkAll(data, data.size());
+    EXPECT_TRUE(validChunks(data, chunks));
+
+    // The average size is roughly what was asked for
+    size_t average = data.size() / chunks.size();
+    EXPECT_GT(average, MIN_SIZE + (AVG_SIZE - MIN_SIZE) / 4);
+    EXPECT_LT(average, MIN_SIZE + (AVG_SIZE - MIN_SIZE) * 2);
+}
+
+TEST(Crc32cChunker, Streaming) {
+    std::vector<char> data = makeData(200000, 2);
+    std::vector<Crc32cChunk> expected = chunkAll(data, data.size());
+
+    // Boundaries do not depend on how the stream is split
+    static const size_t STEPS[] = { 1, 7, 47, 48, 49, 1000, 4096, 65537 };
+    for (size_t i = 0; i < sizeof(STEPS)/sizeof(*STEPS); ++i) {
+        std::vector<Crc32cChunk> chunks = chunkAll(data, STEPS[i]);
+        if (!sameChunks(expected, chunks)) printf("step %zu failed\n", STEPS[i]);
+        EXPECT_TRUE(sameChunks(expected, chunks));
+    }
+}
+
+TEST(Crc32cChunker, Resynchronizes) {
+    std::vector<char> data = makeData(1 << 20, 3);
+    std::vector<Crc32cChunk> original = chunkAll(data, data.size());
+
+    // Insert a few bytes near the start: all chunks after the edit should be found again
+    std::vector<char> edited(data);
+    edited.insert(edited.begin() + 1000, 5, 'x');
+    std::vector<Crc32cChunk> chunks = chunkAll(edited, edited.size());
+    EXPECT_TRUE(validChunks(edited, chunks));
+
+    std::set<uint32_t> crcs;
+    for (size_t i = 0; i < original.size(); ++i) {
+        crcs.insert(original[i].crc);
+    }
+    size_t shared = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        shared += crcs.count(chunks[i].crc);
+    }
+    EXPECT_GE(shared + 3, original.size());
+}
+
+TEST(Crc32cChunker, NoContent) {
+    // Zeros have no boundaries, or boundaries everywhere: either way the limits hold
+    std::vector<char> zeros(100000);
+    EXPECT_TRUE(validChunks(zeros, chunkAll(zeros, 333)));
+
+    // An empty stream has no chunks
+    Crc32cChunker chunker(MIN_SIZE, AVG_SIZE, MAX_SIZE);
+    Crc32cChunk chunk;
+    EXPECT_FALSE(chunker.finish(&chunk));
+
+    // Fixed size chunks
+    std::vector<char> data = makeData(10000, 4);
+    Crc32cChunker fixed(1000, 1000, 1000);
+    std::vector<Crc32cChunk> chunks;
+    EXPECT_EQ(10, fixed.update(&data[0], data.size(), &chunks));
+    EXPECT_FALSE(fixed.finish(&chunk));
+    EXPECT_EQ(9000, chunks[9].offset);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
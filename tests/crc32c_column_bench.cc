@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "crc32c.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+static const size_t NUM_VALUES = 1 << 20;
+
+// Hashes each value with its own crc32c() call.
+template <typename T>
+static void perElement(const T* in, uint32_t* out, size_t count, uint32_t seed) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = crc32c(seed, &in[i], sizeof(T));
+    }
+}
+
+template <typename T>
+static void runTest(const char* name, void (*function)(const T*, uint32_t*, size_t, uint32_t),
+        const std::vector<T>& values) {
+    std::vector<uint32_t> expected(values.size());
+    perElement(&values[0], &expected[0], values.size(), crc32cInit());
+    std::vector<uint32_t> out(values.size());
+    printf("%s,%zu,%zu", name, sizeof(T), values.size());
+    for (int j = 0; j < TRIALS; ++j) {
+        CycleTimer timer;
+        timer.start();
+        function(&values[0], &out[0], values.size(), crc32cInit());
+        timer.end();
+        printf(",%d", timer.getCycles());
+        if (out != expected) {
+            fprintf(stderr, "%s,%zu: wrong CRCs\n", name, sizeof(T));
+            exit(1);
+        }
+    }
+    printf("\n");
+}
+
+int main() {
+    std::vector<uint32_t> values32(NUM_VALUES);
+    std::vector<uint64_t> values64(NUM_VALUES);
+    for (size_t i = 0; i < NUM_VALUES; ++i) {
+        values32[i] = (uint32_t) (i * 2654435761u);
+        values64[i] = i * 0x9e3779b97f4a7c15ULL;
+    }
+    // Resolve the crc32c function pointer
+    crc32c(crc32cInit(), NULL, 0);
+
+    printf("function,value size,count,cycles...\n");
+    runTest<uint32_t>("crc32c", &perElement<uint32_t>, values32);
+    runTest<uint32_t>("crc32cColumnU32", &crc32cColumnU32, values32);
+    runTest<uint64_t>("crc32c", &perElement<uint64_t>, values64);
+    runTest<uint64_t>("crc32cColumnU64", &crc32cColumnU64, values64);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_file.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+// A 2 GB file with 16 data extents of 1 MB, like a mostly empty disk image
+static const uint64_t FILE_SIZE = 2ULL << 30;
+static const int NUM_EXTENTS = 16;
+static const size_t EXTENT_SIZE = 1 << 20;
+
+static uint64_t nowMicros() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+}
+
+// Reads every byte, including the holes. Returns false if the file is short.
+static bool denseCrc(int fd, uint32_t* crcOut) {
+    std::vector<char> buffer(1 << 20);
+    uint32_t crc = crc32cInit();
+    ssize_t bytes;
+    uint64_t offset = 0;
+    while ((bytes = pread(fd, &buffer[0], buffer.size(), offset)) > 0) {
+        crc = crc32c(crc, &buffer[0], bytes);
+        offset += bytes;
+    }
+    *crcOut = crc32cFinish(crc);
+    return offset == FILE_SIZE;
+}
+
+int main() {
+    char path[] = "/tmp/crc32c_file_bench.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    unlink(path);
+    std::vector<char> extent(EXTENT_SIZE);
+    for (size_t i = 0; i < extent.size(); ++i) extent[i] = (char) (i * 7 + 1);
+    for (int i = 0; i < NUM_EXTENTS; ++i) {
+        off_t offset = FILE_SIZE / NUM_EXTENTS * i + 4096;
+        if (pwrite(fd, &extent[0], extent.size(), offset) != (ssize_t) extent.size()) {
+            perror("pwrite");
+            return 1;
+        }
+    }
+    if (ftruncate(fd, FILE_SIZE) != 0) {
+        perror("ftruncate");
+        return 1;
+    }
+
+    uint32_t expected;
+    if (!denseCrc(fd, &expected)) {
+        fprintf(stderr, "short read\n");
+        return 1;
+    }
+    printf("function,bytes,microseconds,microseconds,microseconds,microseconds,microseconds\n");
+
+    printf("dense read,%llu", (unsigned long long) FILE_SIZE);
+    for (int j = 0; j < TRIALS; ++j) {
+        uint64_t start = nowMicros();
+        uint32_t crc = 0;
+        bool success = denseCrc(fd, &crc);
+        printf(",%llu", (unsigned long long) (nowMicros() - start));
+        if (!success || crc != expected) {
+            fprintf(stderr, "dense read: wrong CRC 0x%08x, expected 0x%08x\n", crc, expected);
+            return 1;
+        }
+    }
+    printf("\n");
+
+    printf("crc32cFile,%llu", (unsigned long long) FILE_SIZE);
+    for (int j = 0; j < TRIALS; ++j) {
+        uint64_t start = nowMicros();
+        uint32_t crc = 0;
+        bool success = crc32cFile(fd, &crc);
+        printf(",%llu", (unsigned long long) (nowMicros() - start));
+        if (!success || crc != expected) {
+            fprintf(stderr, "crc32cFile: wrong CRC 0x%08x, expected 0x%08x\n", crc, expected);
+            return 1;
+        }
+    }
+    printf("\n");
+
+    close(fd);
+    return 0;
+}
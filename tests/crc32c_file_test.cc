@@ -0,0 +1,117 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_file.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+// Writes data to a new file, leaving holes where the data is zero in whole 64 kB pieces.
+static void writeSparseFile(const char* path, const std::vector<char>& data) {
+    static const size_t PIECE = 64 << 10;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    for (size_t offset = 0; offset < data.size(); offset += PIECE) {
+        size_t length = std::min(PIECE, data.size() - offset);
+        bool zero = true;
+        for (size_t i = 0; i < length && zero; ++i) zero = data[offset + i] == 0;
+        if (!zero) pwrite(fd, &data[offset], length, offset);
+    }
+    ftruncate(fd, data.size());
+    close(fd);
+}
+
+// Returns 4 MB with data in a few places: a hole at the start, in the middle and at the end.
+static std::vector<char> makeSparseData() {
+    std::vector<char> data(4 << 20, 0);
+    static const size_t EXTENTS[][2] = {
+        { 1 << 20, 100000 },
+        { (2 << 20) + 12345, 300000 },
+        { 3 << 20, 1 << 16 },
+    };
+    for (size_t i = 0; i < sizeof(EXTENTS)/sizeof(*EXTENTS); ++i) {
+        for (size_t j = 0; j < EXTENTS[i][1]; ++j) {
+            data[EXTENTS[i][0] + j] = (char) (j * 7 + i + 1);
+        }
+    }
+    return data;
+}
+
+TEST(Crc32cFile, Sparse) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeSparseData();
+    writeSparseFile("sparse", data);
+
+    int fd = open("sparse", O_RDONLY);
+    uint32_t crc;
+    ASSERT_TRUE(crc32cFile(fd, &crc));
+    EXPECT_EQ(oneshot(data), crc);
+
+    // Ranges that start and end in holes and in data
+    static const size_t RANGES[][2] = {
+        { 0, 1 << 20 },
+        { 0, (1 << 20) + 5 },
+        { (1 << 20) + 50000, 2 << 20 },
+        { (2 << 20) + 12345, 300000 },
+        { (3 << 20) - 1, 1 << 20 },
+        { 4 << 20, 0 },
+    };
+    for (size_t i = 0; i < sizeof(RANGES)/sizeof(*RANGES); ++i) {
+        uint64_t length;
+        ASSERT_TRUE(crc32cFileRange(fd, RANGES[i][0], RANGES[i][1], &crc, &length));
+        EXPECT_EQ(RANGES[i][1], length);
+        EXPECT_EQ(oneshot(data.data() + RANGES[i][0], RANGES[i][1]), crc);
+    }
+
+    // Ranges past the end of the file are clipped
+    uint64_t length;
+    ASSERT_TRUE(crc32cFileRange(fd, (4 << 20) - 10, 100, &crc, &length));
+    EXPECT_EQ(10, length);
+    EXPECT_EQ(oneshot(&data[(4 << 20) - 10], 10), crc);
+    ASSERT_TRUE(crc32cFileRange(fd, 5 << 20, 100, &crc, &length));
+    EXPECT_EQ(0, length);
+    EXPECT_EQ(0, crc);
+    close(fd);
+}
+
+TEST(Crc32cFile, Dense) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data(3000000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char) (i * 13 + (i >> 10));
+    writeSparseFile("dense", data);
+    int fd = open("dense", O_RDONLY);
+    uint32_t crc;
+    ASSERT_TRUE(crc32cFile(fd, &crc));
+    EXPECT_EQ(oneshot(data), crc);
+    close(fd);
+
+    writeSparseFile("empty", std::vector<char>());
+    fd = open("empty", O_RDONLY);
+    ASSERT_TRUE(crc32cFile(fd, &crc));
+    EXPECT_EQ(0, crc);
+    close(fd);
+}
+
+TEST(Crc32cFile, Pipe) {
+    std::vector<char> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = (char) i;
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    ASSERT_EQ(data.size(), write(fds[1], &data[0], data.size()));
+    close(fds[1]);
+    uint32_t crc;
+    ASSERT_TRUE(crc32cFile(fds[0], &crc));
+    EXPECT_EQ(oneshot(data), crc);
+    close(fds[0]);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
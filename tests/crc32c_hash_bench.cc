@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "crc32c_hash.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+static const int NUM_KEYS = 100000;
+
+static const int STRING_LENGTHS[] = {
+    4, 8, 16, 32, 64, 256
+};
+
+// Hashes every key; returns the sum so the compiler cannot discard the work.
+template <typename Hash, typename Key>
+static size_t hashAll(const Hash& hash, const std::vector<Key>& keys) {
+    size_t sum = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sum += hash(keys[i]);
+    }
+    return sum;
+}
+
+// Inserts every key then looks each up once.
+template <typename Hash, typename Key>
+static size_t insertFind(const std::vector<Key>& keys) {
+    std::unordered_map<Key, size_t, Hash> map;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        map[keys[i]] = i;
+    }
+    size_t sum = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sum += map.find(keys[i])->second;
+    }
+    return sum;
+}
+
+template <typename Hash, typename Key>
+static void runHashTest(const char* name, const char* keyType, const std::vector<Key>& keys,
+        size_t keyBytes) {
+    printf("%s,hash,%s,%zu", name, keyType, keyBytes);
+    Hash hash;
+    for (int j = 0; j < TRIALS; ++j) {
+        CycleTimer timer;
+        timer.start();
+        volatile size_t sum = hashAll(hash, keys);
+        (void) sum;
+        timer.end();
+        printf(",%d", timer.getCycles());
+    }
+    printf("\n");
+}
+
+template <typename Hash, typename Key>
+static void runMapTest(const char* name, const char* keyType, const std::vector<Key>& keys,
+        size_t keyBytes) {
+    printf("%s,map,%s,%zu", name, keyType, keyBytes);
+    for (int j = 0; j < TRIALS; ++j) {
+        CycleTimer timer;
+        timer.start();
+        volatile size_t sum = insertFind<Hash>(keys);
+        (void) sum;
+        timer.end();
+        printf(",%d", timer.getCycles());
+    }
+    printf("\n");
+}
+
+int main() {
+    printf("function,operation,key,bytes,cycles,cycles,cycles,cycles,cycles\n");
+
+    std::vector<uint64_t> integers(NUM_KEYS);
+    for (int i = 0; i < NUM_KEYS; ++i) {
+        // Aligned, pointer-like keys: a bad case for identity hashes
+        integers[i] = (uint64_t) i << 4;
+    }
+    runHashTest<std::hash<uint64_t> >("std::hash", "uint64_t", integers, sizeof(uint64_t));
+    runHashTest<Crc32cHash<uint64_t> >("Crc32cHash", "uint64_t", integers, sizeof(uint64_t));
+    runMapTest<std::hash<uint64_t> >("std::hash", "uint64_t", integers, sizeof(uint64_t));
+    runMapTest<Crc32cHash<uint64_t> >("Crc32cHash", "uint64_t", integers, sizeof(uint64_t));
+
+    for (size_t lengthIndex = 0; lengthIndex < sizeof(STRING_LENGTHS)/sizeof(*STRING_LENGTHS);
+            ++lengthIndex) {
+        size_t length = STRING_LENGTHS[lengthIndex];
+        std::vector<std::string> strings(NUM_KEYS);
+        for (int i = 0; i < NUM_KEYS; ++i) {
+            std::string& s = strings[i];
+            s.resize(length);
+            for (size_t k = 0; k < length; ++k) {
+                s[k] = (char) ('a' + (i >> (k % 4 * 5)) % 26);
+            }
+            // Make every key unique regardless of length
+            memcpy(&s[0], &i, length < sizeof(i) ? length : sizeof(i));
+        }
+        runHashTest<std::hash<std::string> >("std::hash", "string", strings, length);
+        runHashTest<Crc32cHash<std::string> >("Crc32cHash", "string", strings, length);
+        runMapTest<std::hash<std::string> >("std::hash", "string", strings, length);
+        runMapTest<Crc32cHash<std::string> >("Crc32cHash", "string", strings, length);
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "crc32c_hash.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+// Returns true if the chi-squared statistic of counts is within 6 standard deviations of the
+// value expected for a uniform distribution.
+static bool isUniform(const std::vector<int>& counts, int total) {
+    double expected = (double) total / counts.size();
+    double chiSquared = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        double delta = counts[i] - expected;
+        chiSquared += delta * delta / expected;
+    }
+    double degrees = counts.size() - 1;
+    double limit = degrees + 6 * sqrt(2 * degrees);
+    if (chiSquared > limit) {
+        printf("chi-squared %f exceeds %f\n", chiSquared, limit);
+        return false;
+    }
+    return true;
+}
+
+static const int NUM_BUCKETS = 1024;
+static const int NUM_KEYS = NUM_BUCKETS * 64;
+
+TEST(Crc32cHash, Functor) {
+    std::string key("The quick brown fox jumps over the lazy dog");
+    EXPECT_EQ(Crc32cHash<std::string>()(key), (size_t) crc32cHash64(key.data(), key.size()));
+#if __cplusplus >= 201703L
+    EXPECT_EQ(Crc32cHash<std::string>()(key), Crc32cHash<std::string_view>()(key));
+#endif
+    EXPECT_EQ(Crc32cHash<int>()(42), Crc32cHash<uint64_t>()(42));
+    EXPECT_NE(Crc32cHash<int>()(42), Crc32cHash<int>()(43));
+
+    // Trailing zeros are part of the key
+    EXPECT_NE(crc32cHash64("a", 1), crc32cHash64("a\0", 2));
+    EXPECT_NE(crc32cHash64("", 0), crc32cHash64("\0", 1));
+    // The seed changes the result
+    EXPECT_NE(crc32cHash64(key.data(), key.size(), 1), crc32cHash64(key.data(), key.size(), 2));
+
+    std::unordered_map<std::string, int, Crc32cHash<std::string> > map;
+    map["one"] = 1;
+    map["two"] = 2;
+    EXPECT_EQ(1, map["one"]);
+    EXPECT_EQ(2, map["two"]);
+    EXPECT_EQ(2, map.size());
+}
+
+TEST(Crc32cHash, SequentialIntegerBuckets) {
+    // Check both the low bits (power-of-two tables) and the high bits
+    std::vector<int> low(NUM_BUCKETS);
+    std::vector<int> high(NUM_BUCKETS);
+    Crc32cHash<uint64_t> hash;
+    for (uint64_t i = 0; i < NUM_KEYS; ++i) {
+        uint64_t h = hash(i);
+        low[h & (NUM_BUCKETS - 1)] += 1;
+        high[h >> 54] += 1;
+    }
+    EXPECT_TRUE(isUniform(low, NUM_KEYS));
+    EXPECT_TRUE(isUniform(high, NUM_KEYS));
+}
+
+TEST(Crc32cHash, StridedIntegerBuckets) {
+    // Keys that only differ in their high bits, like aligned pointers or shifted ids
+    std::vector<int> low(NUM_BUCKETS);
+    Crc32cHash<uint64_t> hash;
+    for (uint64_t i = 0; i < NUM_KEYS; ++i) {
+        low[hash(i << 40) & (NUM_BUCKETS - 1)] += 1;
+    }
+    EXPECT_TRUE(isUniform(low, NUM_KEYS));
+}
+
+TEST(Crc32cHash, StringBuckets) {
+    std::vector<int> buckets(NUM_BUCKETS);
+    Crc32cHash<std::string> hash;
+    char buffer[64];
+    for (int i = 0; i < NUM_KEYS; ++i) {
+        int length = snprintf(buffer, sizeof(buffer), "key:%d", i);
+        buckets[hash(std::string(buffer, length)) & (NUM_BUCKETS - 1)] += 1;
+    }
+    EXPECT_TRUE(isUniform(buckets, NUM_KEYS));
+}
+
+TEST(Crc32cHash, Avalanche) {
+    // Flipping any input bit should flip each output bit with probability close to 1/2
+    static const int SAMPLES = 2000;
+    Crc32cHash<uint64_t> hash;
+    int flips[64][64] = {};
+    uint64_t key = 0x0123456789abcdefULL;
+    for (int sample = 0; sample < SAMPLES; ++sample) {
+        key = key * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t h = hash(key);
+        for (int in = 0; in < 64; ++in) {
+            uint64_t diff = h ^ hash(key ^ ((uint64_t) 1 << in));
+            for (int out = 0; out < 64; ++out) {
+                flips[in][out] += (diff >> out) & 1;
+            }
+        }
+    }
+
+    int biased = 0;
+    for (int in = 0; in < 64; ++in) {
+        for (int out = 0; out < 64; ++out) {
+            double probability = (double) flips[in][out] / SAMPLES;
+            if (probability < 0.4 || probability > 0.6) {
+                printf("input bit %d output bit %d flips with probability %f\n", in, out, probability);
+                biased += 1;
+            }
+        }
+    }
+    EXPECT_EQ(0, biased);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_hasher.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+static const int NUM_FIELDS = 100000;
+
+// Adds fields to a CRC with one crc32c() call per field.
+struct RawCalls {
+    RawCalls() : crc(crc32cInit()) {}
+    void update(const void* data, size_t length) { crc = crc32c(crc, data, length); }
+    uint32_t finish() const { return crc32cFinish(crc); }
+    uint32_t crc;
+};
+
+// Checksums NUM_FIELDS fields of Length bytes each. Serializers know field sizes at compile time.
+template <typename Hasher, size_t Length>
+static uint32_t fields(const char* data) {
+    Hasher hasher;
+    for (int i = 0; i < NUM_FIELDS; ++i) {
+        hasher.update(data, Length);
+        data += Length;
+    }
+    return hasher.finish();
+}
+
+// Checksums records of 10 fields with mixed sizes, NUM_FIELDS fields in total.
+template <typename Hasher>
+static uint32_t records(const char* data) {
+    static const size_t RECORD_LENGTH = 4 + 8 + 1 + 2 + 8 + 5 + 4 + 13 + 1 + 8;
+    Hasher hasher;
+    for (int i = 0; i < NUM_FIELDS / 10; ++i) {
+        hasher.update(data, 4);
+        hasher.update(data + 4, 8);
+        hasher.update(data + 12, 1);
+        hasher.update(data + 13, 2);
+        hasher.update(data + 15, 8);
+        hasher.update(data + 23, 5);
+        hasher.update(data + 28, 4);
+        hasher.update(data + 32, 13);
+        hasher.update(data + 45, 1);
+        hasher.update(data + 46, 8);
+        data += RECORD_LENGTH;
+    }
+    return hasher.finish();
+}
+
+static void runTest(const char* name, const char* fields, uint32_t (*function)(const char*),
+        const std::vector<char>& buffer, size_t bytes) {
+    uint32_t expected = crc32cFinish(crc32c(crc32cInit(), &buffer[0], bytes));
+    printf("%s,%s,%zu", name, fields, bytes);
+    for (int j = 0; j < TRIALS; ++j) {
+        CycleTimer timer;
+        timer.start();
+        uint32_t crc = function(&buffer[0]);
+        timer.end();
+        printf(",%d", timer.getCycles());
+        if (crc != expected) {
+            fprintf(stderr, "%s,%s: wrong CRC 0x%08x, expected 0x%08x\n", name, fields, crc,
+                    expected);
+            exit(1);
+        }
+    }
+    printf("\n");
+}
+
+template <size_t Length>
+static void runFieldTests(const std::vector<char>& buffer) {
+    char name[16];
+    snprintf(name, sizeof(name), "%zu", Length);
+    runTest("crc32c", name, &fields<RawCalls, Length>, buffer, NUM_FIELDS * Length);
+    runTest("Crc32cHasher", name, &fields<Crc32cHasher, Length>, buffer, NUM_FIELDS * Length);
+}
+
+int main() {
+    std::vector<char> buffer(NUM_FIELDS * 16);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = (char) (i * 7 + (i >> 8));
+    }
+
+    printf("function,field bytes,bytes,cycles,cycles,cycles,cycles,cycles\n");
+    runFieldTests<1>(buffer);
+    runFieldTests<2>(buffer);
+    runFieldTests<3>(buffer);
+    runFieldTests<4>(buffer);
+    runFieldTests<8>(buffer);
+    size_t recordBytes = NUM_FIELDS / 10 * 54;
+    runTest("crc32c", "mixed", &records<RawCalls>, buffer, recordBytes);
+    runTest("Crc32cHasher", "mixed", &records<Crc32cHasher>, buffer, recordBytes);
+    return 0;
+}
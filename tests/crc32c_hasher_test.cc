@@ -0,0 +1,57 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_hasher.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+TEST(Crc32cHasher, Empty) {
+    Crc32cHasher hasher;
+    EXPECT_EQ(0, hasher.finish());
+    hasher.update(NULL, 0);
+    EXPECT_EQ(0, hasher.finish());
+}
+
+TEST(Crc32cHasher, PieceLengths) {
+    std::vector<char> data = makeData(5000);
+    // Every piece length up to 600, repeated so the pending bytes reach every alignment
+    for (size_t pieceLength = 1; pieceLength < 600; ++pieceLength) {
+        Crc32cHasher hasher;
+        size_t offset = 0;
+        for (; offset + pieceLength <= data.size(); offset += pieceLength) {
+            hasher.update(&data[offset], pieceLength);
+            if (offset < 100) EXPECT_EQ(oneshot(&data[0], offset + pieceLength), hasher.finish());
+        }
+        EXPECT_EQ(oneshot(&data[0], offset), hasher.finish());
+    }
+}
+
+TEST(Crc32cHasher, MixedPieces) {
+    std::vector<char> data = makeData(20000);
+    static const size_t LENGTHS[] = { 1, 4, 2, 8, 3, 0, 7, 300, 5, 6, 1000, 1, 9, 16, 17 };
+    Crc32cHasher hasher;
+    size_t offset = 0;
+    for (size_t i = 0; offset < 19000; i = (i + 1) % (sizeof(LENGTHS)/sizeof(*LENGTHS))) {
+        hasher.update(&data[offset], LENGTHS[i]);
+        offset += LENGTHS[i];
+    }
+    EXPECT_EQ(oneshot(&data[0], offset), hasher.finish());
+
+    // Continue from an unfinished CRC, and reset
+    Crc32cHasher second(crc32c(crc32cInit(), &data[0], 10));
+    second.update(&data[10], 3);
+    EXPECT_EQ(crc32c(crc32cInit(), &data[0], 13), second.value());
+    second.reset();
+    second.update(&data[0], 3);
+    EXPECT_EQ(oneshot(&data[0], 3), second.finish());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,118 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <errno.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_manifest.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static std::string formatLine(uint64_t length, uint32_t crc) {
+    char line[64];
+    snprintf(line, sizeof(line), "%" PRIu64 " %08x\n", length, crc);
+    return line;
+}
+
+TEST(Crc32cManifest, Combine) {
+    std::vector<char> data = makeData(300000);
+    Crc32cManifest manifest;
+    EXPECT_EQ(0, manifest.objectCrc());
+    // Runs of equal and varying lengths, and an empty shard
+    static const size_t LENGTHS[] = { 4096, 4096, 4096, 0, 17, 100000, 100000, 1, 4096 };
+    size_t offset = 0;
+    for (size_t i = 0; i < sizeof(LENGTHS)/sizeof(*LENGTHS); ++i) {
+        manifest.add(LENGTHS[i], oneshot(&data[offset], LENGTHS[i]));
+        offset += LENGTHS[i];
+        EXPECT_EQ(offset, manifest.objectLength());
+        EXPECT_EQ(oneshot(&data[0], offset), manifest.objectCrc());
+    }
+    EXPECT_EQ(9, manifest.numShards());
+    EXPECT_EQ(17, manifest.shardLength(4));
+    EXPECT_TRUE(manifest.consistent());
+}
+
+TEST(Crc32cManifest, Parse) {
+    std::vector<char> data = makeData(10000);
+    std::string text = "# shards of data\n\n";
+    text += formatLine(6000, oneshot(&data[0], 6000));
+    text += "  " + formatLine(4000, oneshot(&data[6000], 4000));
+    uint32_t crc = oneshot(&data[0], data.size());
+    text += "total " + formatLine(10000, crc);
+
+    Crc32cManifest manifest;
+    ASSERT_TRUE(manifest.parse(text.data(), text.size()));
+    EXPECT_EQ(2, manifest.numShards());
+    EXPECT_EQ(crc, manifest.objectCrc());
+    EXPECT_TRUE(manifest.hasRecorded());
+    EXPECT_EQ(10000, manifest.recordedLength());
+    EXPECT_TRUE(manifest.consistent());
+
+    // A missing shard is detected by the length, a corrupt one by the CRC
+    std::string missing = text.substr(text.find('\n', 20) + 1);
+    ASSERT_TRUE(manifest.parse(missing.data(), missing.size()));
+    EXPECT_EQ(1, manifest.numShards());
+    EXPECT_FALSE(manifest.consistent());
+    std::string corrupt = text;
+    corrupt[corrupt.find("6000 ") + 5] ^= 1;
+    ASSERT_TRUE(manifest.parse(corrupt.data(), corrupt.size()));
+    EXPECT_EQ(10000, manifest.objectLength());
+    EXPECT_FALSE(manifest.consistent());
+}
+
+TEST(Crc32cManifest, Malformed) {
+    static const char* const BAD[] = {
+        "100\n",
+        "100 abcdefgh\n",
+        "100 123456789\n",
+        "-1 00000000\n",
+        "18446744073709551616 00000000\n",
+        "100 00000000 extra\n",
+        "total 100\n",
+        "total 1 00000000\ntotal 1 00000000\n",
+    };
+    Crc32cManifest manifest;
+    for (size_t i = 0; i < sizeof(BAD)/sizeof(*BAD); ++i) {
+        std::string text = std::string("1 00000000\n") + BAD[i];
+        EXPECT_FALSE(manifest.parse(text.data(), text.size()));
+        EXPECT_EQ(EINVAL, errno);
+        EXPECT_EQ(2 + (i == 7), manifest.errorLine());
+    }
+    // No trailing newline is fine
+    EXPECT_TRUE(manifest.parse("5 0a0b0c0d", 10));
+    EXPECT_EQ(0x0a0b0c0d, manifest.objectCrc());
+}
+
+TEST(Crc32cManifest, ManyShards) {
+    // Every shard is zeros, so the CRCs can be computed without data
+    static const size_t NUM_SHARDS = 200000;
+    std::string text;
+    uint64_t total = 0;
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        // Mostly equal lengths, with every tenth shard a different length
+        uint64_t length = i % 10 == 0 ? 1000 + i : 1 << 20;
+        text += formatLine(length, crc32cFinish(crc32cShift(crc32cInit(),
+                crc32cShiftOperator(length))));
+        total += length;
+    }
+
+    Crc32cManifest manifest;
+    ASSERT_TRUE(manifest.parse(text.data(), text.size()));
+    EXPECT_EQ(NUM_SHARDS, manifest.numShards());
+    EXPECT_EQ(total, manifest.objectLength());
+    EXPECT_EQ(crc32cFinish(crc32cShift(crc32cInit(), crc32cShiftOperator(total))),
+            manifest.objectCrc());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,83 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cstring>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_pages.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static std::vector<uint32_t> pageCrcs(const std::vector<char>& data, size_t pageSize) {
+    std::vector<uint32_t> crcs(data.size() / pageSize);
+    for (size_t i = 0; i < crcs.size(); ++i) {
+        crcs[i] = oneshot(&data[i * pageSize], pageSize);
+    }
+    return crcs;
+}
+
+TEST(Crc32cPages, VerifyPages) {
+    static const size_t PAGE_SIZES[] = { 4096, 8192, 65536, 100 };
+    for (size_t s = 0; s < sizeof(PAGE_SIZES)/sizeof(*PAGE_SIZES); ++s) {
+        size_t pageSize = PAGE_SIZES[s];
+        // Not a multiple of 8 or of the interleaving
+        size_t count = 37;
+        std::vector<char> data = makeData(count * pageSize);
+        std::vector<uint32_t> expected = pageCrcs(data, pageSize);
+
+        uint8_t bitmap[5];
+        memset(bitmap, 0xff, sizeof(bitmap));
+        EXPECT_EQ(0, crc32cVerifyPages(&data[0], pageSize, count, &expected[0], bitmap));
+        for (size_t i = 0; i < 4; ++i) {
+            EXPECT_EQ(0, bitmap[i]);
+        }
+        // Bits past the last page are untouched
+        EXPECT_EQ(0xe0, bitmap[4]);
+
+        data[3 * pageSize + 17] ^= 1;
+        data[36 * pageSize + pageSize - 1] ^= 0x80;
+        expected[20] ^= 1;
+        EXPECT_EQ(3, crc32cVerifyPages(&data[0], pageSize, count, &expected[0], bitmap));
+        EXPECT_EQ(1 << 3, bitmap[0]);
+        EXPECT_EQ(1 << 4, bitmap[2]);
+        EXPECT_EQ(0xe0 | (1 << 4), bitmap[4]);
+        EXPECT_EQ(3, crc32cVerifyPages(&data[0], pageSize, count, &expected[0], NULL));
+    }
+}
+
+TEST(Crc32cPages, CorruptPages) {
+    static const size_t PAGE_SIZE = 8192;
+    static const size_t COUNT = 1003;
+    std::vector<char> data = makeData(COUNT * PAGE_SIZE);
+    std::vector<uint32_t> expected = pageCrcs(data, PAGE_SIZE);
+
+    static const size_t CORRUPT[] = { 0, 7, 8, 500, 501, 1002 };
+    static const size_t NUM_CORRUPT = sizeof(CORRUPT)/sizeof(*CORRUPT);
+    for (size_t i = 0; i < NUM_CORRUPT; ++i) {
+        data[CORRUPT[i] * PAGE_SIZE + 100] ^= 0x10;
+    }
+    for (int threads = 1; threads <= 4; ++threads) {
+        std::vector<uint8_t> bitmap((COUNT + 7) / 8, 0xff);
+        std::vector<size_t> corrupt = crc32cCorruptPages(&data[0], PAGE_SIZE, COUNT,
+                &expected[0], &bitmap[0], threads);
+        ASSERT_EQ(NUM_CORRUPT, corrupt.size());
+        for (size_t i = 0; i < NUM_CORRUPT; ++i) {
+            EXPECT_EQ(CORRUPT[i], corrupt[i]);
+        }
+        EXPECT_EQ(0x81, bitmap[0]);
+        EXPECT_EQ(0x01, bitmap[1]);
+        EXPECT_EQ(0, bitmap[2]);
+    }
+
+    EXPECT_TRUE(crc32cCorruptPages(&data[0], PAGE_SIZE, 0, &expected[0]).empty());
+    EXPECT_TRUE(crc32cCorruptPages(&data[PAGE_SIZE], PAGE_SIZE, 6, &expected[1], NULL,
+            4).empty());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,60 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_prefix_index.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static const size_t BLOCK_SIZES[] = { 1, 64, 1000, 4096, 1 << 20 };
+
+TEST(Crc32cPrefixIndex, WholeBuffer) {
+    std::vector<char> data = makeData(300001, 1);
+    for (size_t i = 0; i < sizeof(BLOCK_SIZES)/sizeof(*BLOCK_SIZES); ++i) {
+        for (int threads = 1; threads <= 4; threads += 3) {
+            Crc32cPrefixIndex index(&data[0], data.size(), BLOCK_SIZES[i], threads);
+            EXPECT_EQ(oneshot(data), index.crc());
+            EXPECT_EQ(oneshot(data), index.rangeCrc(0, data.size()));
+        }
+    }
+
+    Crc32cPrefixIndex empty(NULL, 0, 4096, 4);
+    EXPECT_EQ(0, empty.crc());
+    EXPECT_EQ(0, empty.rangeCrc(0, 0));
+}
+
+TEST(Crc32cPrefixIndex, Ranges) {
+    std::vector<char> data = makeData(100003, 2);
+    uint32_t x = 3;
+    for (size_t i = 0; i < sizeof(BLOCK_SIZES)/sizeof(*BLOCK_SIZES); ++i) {
+        Crc32cPrefixIndex index(&data[0], data.size(), BLOCK_SIZES[i], 3);
+        int errors = 0;
+        for (int trial = 0; trial < 500; ++trial) {
+            x = x * 1103515245 + 12345;
+            size_t offset = (x >> 8) % (data.size() + 1);
+            x = x * 1103515245 + 12345;
+            size_t length = (x >> 8) % (data.size() - offset + 1);
+            // Include short ranges and ranges that end on block boundaries
+            if (trial % 3 == 1) length %= 2 * BLOCK_SIZES[i];
+            size_t boundary = (offset + length) / BLOCK_SIZES[i] * BLOCK_SIZES[i];
+            if (trial % 3 == 2 && boundary >= offset) length = boundary - offset;
+
+            if (index.rangeCrc(offset, length) != oneshot(&data[offset], length)) {
+                printf("block size %zu offset %zu length %zu failed\n", BLOCK_SIZES[i], offset,
+                        length);
+                errors += 1;
+            }
+        }
+        EXPECT_EQ(0, errors);
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
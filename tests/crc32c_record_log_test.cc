@@ -0,0 +1,152 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_record_log.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+// Returns the payload of record i: its length varies, including empty records.
+static std::string makePayload(int i) {
+    std::string payload((i * 37) % 300, 'a');
+    for (size_t j = 0; j < payload.size(); ++j) {
+        payload[j] = (char) (i * 131 + j * 7);
+    }
+    return payload;
+}
+
+static std::string makeLog(int numRecords) {
+    std::string log;
+    Crc32cRecordWriter writer(&log);
+    for (int i = 0; i < numRecords; ++i) {
+        std::string payload = makePayload(i);
+        writer.append(payload.data(), payload.size());
+    }
+    return log;
+}
+
+static std::vector<Crc32cRecord> readAll(Crc32cRecordReader* reader) {
+    std::vector<Crc32cRecord> records;
+    while (reader->read(&records, 7) > 0) {}
+    return records;
+}
+
+TEST(Crc32cRecordLog, Mask) {
+    static const uint32_t VALUES[] = { 0, 1, 0x22620404, 0xFFFFFFFF };
+    for (size_t i = 0; i < sizeof(VALUES)/sizeof(*VALUES); ++i) {
+        EXPECT_NE(VALUES[i], crc32cMask(VALUES[i]));
+        EXPECT_EQ(VALUES[i], crc32cUnmask(crc32cMask(VALUES[i])));
+        EXPECT_NE(crc32cMask(VALUES[i]), crc32cMask(crc32cMask(VALUES[i])));
+    }
+}
+
+TEST(Crc32cRecordLog, Batch) {
+    // Compare crc32cBatch against crc32c for buffers of assorted lengths
+    std::vector<std::string> buffers;
+    for (int i = 0; i < 23; ++i) buffers.push_back(makePayload(i * 5));
+    std::vector<const void*> data;
+    std::vector<size_t> lengths;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        data.push_back(buffers[i].data());
+        lengths.push_back(buffers[i].size());
+    }
+    std::vector<uint32_t> crcs(buffers.size());
+    crc32cBatch(&data[0], &lengths[0], &crcs[0], buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        EXPECT_EQ(crc32cFinish(crc32c(crc32cInit(), buffers[i].data(), buffers[i].size())), crcs[i]);
+    }
+}
+
+TEST(Crc32cRecordLog, RoundTrip) {
+    std::string log = makeLog(100);
+    Crc32cRecordReader reader(log.data(), log.size());
+    std::vector<Crc32cRecord> records = readAll(&reader);
+    ASSERT_EQ(100, records.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(makePayload(i), std::string(records[i].data, records[i].length));
+        // Zero copy: the views point into the log
+        EXPECT_EQ(log.data() + records[i].offset + Crc32cRecordReader::HEADER_SIZE, records[i].data);
+    }
+    EXPECT_EQ(log.size(), reader.consumed());
+    EXPECT_EQ(0, reader.numCorruptions());
+    EXPECT_EQ(0, reader.skippedBytes());
+
+    // encodeHeader agrees with append
+    std::string payload = makePayload(5);
+    char header[8];
+    Crc32cRecordWriter::encodeHeader(payload.data(), payload.size(), header);
+    std::string single;
+    Crc32cRecordWriter(&single).append(payload.data(), payload.size());
+    EXPECT_EQ(0, memcmp(header, single.data(), sizeof(header)));
+}
+
+TEST(Crc32cRecordLog, CorruptPayload) {
+    std::string log = makeLog(50);
+    std::vector<Crc32cRecord> original;
+    Crc32cRecordReader(log.data(), log.size()).read(&original);
+
+    // Flip a byte in the payload of record 20: only that record is lost
+    size_t corruptOffset = original[20].offset + Crc32cRecordReader::HEADER_SIZE + 3;
+    log[corruptOffset] ^= 1;
+    Crc32cRecordReader reader(log.data(), log.size());
+    std::vector<Crc32cRecord> records = readAll(&reader);
+    ASSERT_EQ(49, records.size());
+    EXPECT_EQ(original[19].offset, records[19].offset);
+    EXPECT_EQ(original[21].offset, records[20].offset);
+    EXPECT_EQ(1, reader.numCorruptions());
+    EXPECT_EQ(original[21].offset - original[20].offset, reader.skippedBytes());
+}
+
+TEST(Crc32cRecordLog, CorruptLength) {
+    std::string log = makeLog(50);
+    std::vector<Crc32cRecord> original;
+    Crc32cRecordReader(log.data(), log.size()).read(&original);
+
+    // A corrupt length misplaces every later header in the batch: they must not be trusted
+    log[original[10].offset] ^= 0x10;
+    Crc32cRecordReader reader(log.data(), log.size());
+    std::vector<Crc32cRecord> records = readAll(&reader);
+    ASSERT_EQ(49, records.size());
+    EXPECT_EQ(original[11].offset, records[10].offset);
+    for (size_t i = 10; i < records.size(); ++i) {
+        EXPECT_EQ(makePayload(i + 1), std::string(records[i].data, records[i].length));
+    }
+}
+
+TEST(Crc32cRecordLog, Streaming) {
+    std::string log = makeLog(30);
+    // Feed the log in pieces, resuming from consumed()
+    std::vector<std::string> payloads;
+    size_t start = 0;
+    for (size_t end = 100; start < log.size(); end += 100) {
+        if (end > log.size()) end = log.size();
+        Crc32cRecordReader reader(log.data() + start, end - start, end == log.size());
+        std::vector<Crc32cRecord> records = readAll(&reader);
+        for (size_t i = 0; i < records.size(); ++i) {
+            payloads.push_back(std::string(records[i].data, records[i].length));
+        }
+        EXPECT_EQ(0, reader.skippedBytes());
+        start += reader.consumed();
+    }
+    ASSERT_EQ(30, payloads.size());
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_EQ(makePayload(i), payloads[i]);
+    }
+
+    // A complete buffer that ends in the middle of a record skips the tail
+    Crc32cRecordReader reader(log.data(), log.size() - 5);
+    EXPECT_EQ(29, readAll(&reader).size());
+    EXPECT_EQ(log.size() - 5, reader.consumed());
+    EXPECT_GT(reader.skippedBytes(), 0);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_rolling.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+static const int BUFFER_SIZE = 65536;
+
+static const int WINDOWS[] = {
+    16, 64, 256, 4096
+};
+
+// Computes the CRC of every window by recomputing it from scratch.
+static void recomputeAll(const char* data, size_t length, size_t window, uint32_t* crcs) {
+    for (size_t i = 0; i + window <= length; ++i) {
+        crcs[i] = crc32cFinish(crc32c(crc32cInit(), data + i, window));
+    }
+}
+
+int main() {
+    std::vector<char> buffer(BUFFER_SIZE);
+    for (int i = 0; i < BUFFER_SIZE; ++i) {
+        buffer[i] = (char) (i * 7 + (i >> 8));
+    }
+    std::vector<uint32_t> crcs(BUFFER_SIZE);
+    std::vector<uint32_t> expected(BUFFER_SIZE);
+
+    printf("function,window,bytes,cycles,cycles,cycles,cycles,cycles\n");
+    for (size_t windowIndex = 0; windowIndex < sizeof(WINDOWS)/sizeof(*WINDOWS); ++windowIndex) {
+        size_t window = WINDOWS[windowIndex];
+        RollingCrc32c rolling(window);
+
+        printf("crc32c,%zu,%d", window, BUFFER_SIZE);
+        for (int j = 0; j < TRIALS; ++j) {
+            CycleTimer timer;
+            timer.start();
+            recomputeAll(&buffer[0], buffer.size(), window, &expected[0]);
+            timer.end();
+            printf(",%d", timer.getCycles());
+        }
+        printf("\n");
+
+        printf("RollingCrc32c::rollBuffer,%zu,%d", window, BUFFER_SIZE);
+        for (int j = 0; j < TRIALS; ++j) {
+            CycleTimer timer;
+            timer.start();
+            rolling.rollBuffer(&buffer[0], buffer.size(), &crcs[0]);
+            timer.end();
+            printf(",%d", timer.getCycles());
+        }
+        printf("\n");
+
+        printf("RollingCrc32c::roll,%zu,%d", window, BUFFER_SIZE);
+        for (int j = 0; j < TRIALS; ++j) {
+            CycleTimer timer;
+            timer.start();
+            uint32_t crc = crcs[0] = rolling.start(&buffer[0]);
+            for (size_t i = 1; i + window <= buffer.size(); ++i) {
+                crc = rolling.roll(crc, buffer[i - 1], buffer[i - 1 + window]);
+                crcs[i] = crc;
+            }
+            timer.end();
+            printf(",%d", timer.getCycles());
+        }
+        printf("\n");
+
+        for (size_t i = 0; i + window <= buffer.size(); ++i) {
+            if (crcs[i] != expected[i]) {
+                fprintf(stderr, "window %zu offset %zu: wrong CRC 0x%08x, expected 0x%08x\n",
+                        window, i, crcs[i], expected[i]);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cstdio>
+#include <vector>
+
+#include "crc32c_rolling.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static const size_t WINDOWS[] = { 1, 3, 8, 48, 1000 };
+
+TEST(RollingCrc32c, Roll) {
+    std::vector<char> data = makeData(4000, 0x12345678);
+    for (size_t w = 0; w < sizeof(WINDOWS)/sizeof(*WINDOWS); ++w) {
+        RollingCrc32c rolling(WINDOWS[w]);
+        uint32_t crc = rolling.start(&data[0]);
+        EXPECT_EQ(oneshot(&data[0], WINDOWS[w]), crc);
+        for (size_t i = 1; i + WINDOWS[w] <= data.size(); ++i) {
+            crc = rolling.roll(crc, data[i - 1], data[i - 1 + WINDOWS[w]]);
+            if (crc != oneshot(&data[i], WINDOWS[w])) {
+                printf("window %zu offset %zu failed\n", WINDOWS[w], i);
+                EXPECT_EQ(oneshot(&data[i], WINDOWS[w]), crc);
+                break;
+            }
+        }
+    }
+}
+
+TEST(RollingCrc32c, RollBuffer) {
+    // Long enough to use the interleaved chains, with windows left over after the split
+    std::vector<char> data = makeData(5 * 4096 + 7, 0x12345678);
+    for (size_t w = 0; w < sizeof(WINDOWS)/sizeof(*WINDOWS); ++w) {
+        RollingCrc32c rolling(WINDOWS[w]);
+        size_t count = data.size() - WINDOWS[w] + 1;
+        std::vector<uint32_t> crcs(count);
+        rolling.rollBuffer(&data[0], data.size(), &crcs[0]);
+        size_t errors = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (crcs[i] != oneshot(&data[i], WINDOWS[w])) errors += 1;
+        }
+        EXPECT_EQ(0, errors);
+
+        // Shorter than the window: nothing to do
+        rolling.rollBuffer(&data[0], WINDOWS[w] - 1, NULL);
+    }
+}
+
+TEST(RollingCrc32c, Find) {
+    static const size_t WINDOW = 32;
+    std::vector<char> data = makeData(100000, 0x12345678);
+    RollingCrc32c rolling(WINDOW);
+
+    static const size_t OFFSETS[] = { 0, 17, 4096, 50001, 100000 - WINDOW };
+    for (size_t i = 0; i < sizeof(OFFSETS)/sizeof(*OFFSETS); ++i) {
+        uint32_t target = oneshot(&data[OFFSETS[i]], WINDOW);
+        EXPECT_EQ(OFFSETS[i], rolling.find(&data[0], data.size(), target));
+    }
+
+    // A signature that is not in the data
+    std::vector<char> other = makeData(WINDOW, 0x12345678);
+    for (size_t i = 0; i < other.size(); ++i) other[i] ^= 0x5a;
+    uint32_t missing = oneshot(&other[0], WINDOW);
+    EXPECT_EQ(RollingCrc32c::NOT_FOUND, rolling.find(&data[0], data.size(), missing));
+    // Shorter than the window
+    EXPECT_EQ(RollingCrc32c::NOT_FOUND,
+            rolling.find(&data[0], WINDOW - 1, oneshot(&data[0], WINDOW)));
+}
+
+TEST(RollingCrc32c, FindMasked) {
+    static const size_t WINDOW = 48;
+    std::vector<char> data = makeData(100000, 0x12345678);
+    RollingCrc32c rolling(WINDOW);
+    std::vector<uint32_t> crcs(data.size() - WINDOW + 1);
+    rolling.rollBuffer(&data[0], data.size(), &crcs[0]);
+
+    // Masks with matches in every chain of a batch, a few per buffer, and none; starts and
+    // lengths that put the first match in each chain and in the leftover windows
+    static const uint32_t MASKS[] = { 0x3f, 0xfff, 0x7fff, 0xffffffff };
+    static const size_t STARTS[] = { 0, 1, 333, 5000 };
+    static const size_t LENGTHS[] = { WINDOW - 1, WINDOW, 100, 1100, 3000, 50000 };
+    int errors = 0;
+    for (size_t m = 0; m < sizeof(MASKS)/sizeof(*MASKS); ++m) {
+        for (size_t s = 0; s < sizeof(STARTS)/sizeof(*STARTS); ++s) {
+            for (size_t l = 0; l < sizeof(LENGTHS)/sizeof(*LENGTHS); ++l) {
+                size_t start = STARTS[s];
+                size_t length = LENGTHS[l];
+                size_t expected = RollingCrc32c::NOT_FOUND;
+                for (size_t i = start; i + WINDOW <= start + length; ++i) {
+                    if ((crcs[i] & MASKS[m]) == 0) {
+                        expected = i - start;
+                        break;
+                    }
+                }
+                if (rolling.findMasked(&data[start], length, MASKS[m]) != expected) errors += 1;
+            }
+        }
+    }
+    EXPECT_EQ(0, errors);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
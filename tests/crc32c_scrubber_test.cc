@@ -0,0 +1,239 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_scrubber.h"
+#include "crc32c_sidecar.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static uint32_t writeFile(const char* path, const std::vector<char>& data) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!data.empty()) write(fd, &data[0], data.size());
+    close(fd);
+    return oneshot(data);
+}
+
+static void overwriteByte(const char* path, off_t offset) {
+    int fd = open(path, O_RDWR);
+    char byte;
+    pread(fd, &byte, 1, offset);
+    byte ^= 1;
+    pwrite(fd, &byte, 1, offset);
+    close(fd);
+}
+
+// Sets the modification time of path to the one recorded in sidecar.
+static void restoreMtime(const char* path, const Crc32cSidecar& sidecar) {
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_OMIT;
+    times[1].tv_sec = sidecar.mtimeNanos() / 1000000000;
+    times[1].tv_nsec = sidecar.mtimeNanos() % 1000000000;
+    utimensat(AT_FDCWD, path, times, 0);
+}
+
+static bool neverBusy() {
+    return false;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Mismatch {
+    std::string path;
+    uint64_t offset;
+    uint64_t length;
+};
+
+TEST(Crc32cScrubber, Files) {
+    stupidunit::ChTempDir temp;
+    uint32_t goodCrc = writeFile("good", makeData(3000000, 1));
+    uint32_t badCrc = writeFile("bad", makeData(100000, 2));
+    overwriteByte("bad", 5000);
+
+    Crc32cScrubber scrubber(0);
+    scrubber.setBusyFunction(neverBusy);
+    std::vector<Mismatch> mismatches;
+    scrubber.setMismatchFunction([&mismatches](const std::string& path, uint64_t offset,
+            uint64_t length) {
+        Mismatch mismatch = { path, offset, length };
+        mismatches.push_back(mismatch);
+    });
+    scrubber.addFile("good", goodCrc);
+    scrubber.addFile("bad", badCrc);
+    scrubber.addFile("missing", 0);
+    EXPECT_TRUE(scrubber.scrub());
+
+    EXPECT_EQ(1, scrubber.passes());
+    EXPECT_EQ(3100000, scrubber.bytesVerified());
+    EXPECT_EQ(3100000, scrubber.passBytesVerified());
+    EXPECT_EQ(3100000, scrubber.passBytesTotal());
+    EXPECT_EQ(1, scrubber.mismatches());
+    EXPECT_EQ(1, scrubber.errors());
+    ASSERT_EQ(1, mismatches.size());
+    EXPECT_EQ("bad", mismatches[0].path);
+    EXPECT_EQ(0, mismatches[0].offset);
+    EXPECT_EQ(100000, mismatches[0].length);
+
+    EXPECT_TRUE(scrubber.scrub());
+    EXPECT_EQ(2, scrubber.passes());
+    EXPECT_EQ(6200000, scrubber.bytesVerified());
+    EXPECT_EQ(2, scrubber.mismatches());
+}
+
+TEST(Crc32cScrubber, Sidecar) {
+    stupidunit::ChTempDir temp;
+    writeFile("data", makeData(10 * 4096 + 10, 3));
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, 4096));
+    close(fd);
+    ASSERT_TRUE(sidecar.write(Crc32cSidecar::sidecarPath("data")));
+    overwriteByte("data", 7 * 4096 + 1);
+    restoreMtime("data", sidecar);
+
+    Crc32cScrubber scrubber(0);
+    scrubber.setBusyFunction(neverBusy);
+    std::vector<Mismatch> mismatches;
+    scrubber.setMismatchFunction([&mismatches](const std::string& path, uint64_t offset,
+            uint64_t length) {
+        Mismatch mismatch = { path, offset, length };
+        mismatches.push_back(mismatch);
+    });
+    scrubber.addSidecarFile("data");
+    scrubber.addSidecarFile("no_sidecar");
+    EXPECT_TRUE(scrubber.scrub());
+    EXPECT_EQ(10 * 4096 + 10, scrubber.bytesVerified());
+    EXPECT_EQ(1, scrubber.mismatches());
+    EXPECT_EQ(1, scrubber.errors());
+    ASSERT_EQ(1, mismatches.size());
+    EXPECT_EQ(7 * 4096, mismatches[0].offset);
+    EXPECT_EQ(4096, mismatches[0].length);
+}
+
+TEST(Crc32cScrubber, StaleSidecar) {
+    stupidunit::ChTempDir temp;
+    writeFile("data", makeData(4096, 7));
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, 1024));
+    close(fd);
+    ASSERT_TRUE(sidecar.write(Crc32cSidecar::sidecarPath("data")));
+    writeFile("data", makeData(4000, 8));
+
+    Crc32cScrubber scrubber(0);
+    scrubber.setBusyFunction(neverBusy);
+    std::vector<std::string> stale;
+    scrubber.setStaleFunction([&stale](const std::string& path) { stale.push_back(path); });
+    scrubber.addSidecarFile("data");
+    EXPECT_TRUE(scrubber.scrub());
+    EXPECT_EQ(1, scrubber.staleSidecars());
+    EXPECT_EQ(0, scrubber.mismatches());
+    EXPECT_EQ(0, scrubber.errors());
+    EXPECT_EQ(0, scrubber.bytesVerified());
+    ASSERT_EQ(1, stale.size());
+    EXPECT_EQ("data", stale[0]);
+}
+
+TEST(Crc32cScrubber, LargeBlocks) {
+    stupidunit::ChTempDir temp;
+    // Blocks larger than a chunk are throttled a chunk at a time: 0.2 s at 10 MB/s
+    writeFile("data", makeData(3 << 20, 9));
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, 2 << 20));
+    close(fd);
+    ASSERT_TRUE(sidecar.write(Crc32cSidecar::sidecarPath("data")));
+    overwriteByte("data", (2 << 20) + 5);
+    restoreMtime("data", sidecar);
+
+    Crc32cScrubber scrubber(10 << 20);
+    scrubber.setBusyFunction(neverBusy);
+    std::vector<Mismatch> mismatches;
+    scrubber.setMismatchFunction([&mismatches](const std::string& path, uint64_t offset,
+            uint64_t length) {
+        Mismatch mismatch = { path, offset, length };
+        mismatches.push_back(mismatch);
+    });
+    scrubber.addSidecarFile("data");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(scrubber.scrub());
+    EXPECT_GE(secondsSince(start), 0.18);
+    EXPECT_EQ(3 << 20, scrubber.bytesVerified());
+    ASSERT_EQ(1, mismatches.size());
+    EXPECT_EQ(2 << 20, mismatches[0].offset);
+    EXPECT_EQ(1 << 20, mismatches[0].length);
+}
+
+TEST(Crc32cScrubber, RateLimit) {
+    stupidunit::ChTempDir temp;
+    // The first chunk is a burst: the other 2 MB take 0.2 s at 10 MB/s
+    uint32_t crc = writeFile("data", makeData(3 << 20, 4));
+    Crc32cScrubber scrubber(10 << 20);
+    scrubber.setBusyFunction(neverBusy);
+    scrubber.addFile("data", crc);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(scrubber.scrub());
+    double seconds = secondsSince(start);
+    EXPECT_GE(seconds, 0.18);
+    EXPECT_LT(seconds, 2.0);
+    EXPECT_EQ(0, scrubber.mismatches());
+}
+
+TEST(Crc32cScrubber, Busy) {
+    stupidunit::ChTempDir temp;
+    uint32_t crc = writeFile("data", makeData(100, 5));
+    Crc32cScrubber scrubber(0);
+    int busyCalls = 0;
+    scrubber.setBusyFunction([&busyCalls]() { return ++busyCalls <= 3; });
+    scrubber.addFile("data", crc);
+    EXPECT_TRUE(scrubber.scrub());
+    EXPECT_EQ(3, scrubber.pauses());
+    EXPECT_EQ(100, scrubber.bytesVerified());
+}
+
+TEST(Crc32cScrubber, Stop) {
+    stupidunit::ChTempDir temp;
+    uint32_t crc = writeFile("data", makeData(10 << 20, 6));
+    Crc32cScrubber scrubber(1 << 20);
+    scrubber.setBusyFunction(neverBusy);
+    scrubber.addFile("data", crc);
+    std::thread stopper([&scrubber]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scrubber.stop();
+    });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(scrubber.scrub());
+    double seconds = secondsSince(start);
+    stopper.join();
+    EXPECT_LT(seconds, 1.0);
+    EXPECT_EQ(0, scrubber.passes());
+    EXPECT_LT(scrubber.passBytesVerified(), scrubber.passBytesTotal());
+
+    // A stopped scrubber can scrub again
+    std::thread restopper([&scrubber]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scrubber.stop();
+    });
+    EXPECT_FALSE(scrubber.scrub());
+    restopper.join();
+    EXPECT_GT(scrubber.passBytesVerified(), 0);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,197 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_sidecar.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static void writeFile(const char* path, const std::vector<char>& data) {
+    FILE* file = fopen(path, "wb");
+    if (!data.empty()) fwrite(&data[0], 1, data.size(), file);
+    fclose(file);
+}
+
+static void overwriteByte(const char* path, off_t offset, char value) {
+    int fd = open(path, O_WRONLY);
+    pwrite(fd, &value, 1, offset);
+    close(fd);
+}
+
+static const uint32_t BLOCK_SIZE = 4096;
+
+TEST(Crc32cSidecar, RoundTrip) {
+    stupidunit::ChTempDir temp;
+    // Not a multiple of the block size: the last block is short
+    std::vector<char> data = makeData(10 * BLOCK_SIZE + 123, 1);
+    writeFile("data", data);
+
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    EXPECT_EQ(11, sidecar.numBlocks());
+    EXPECT_EQ(data.size(), sidecar.fileLength());
+    EXPECT_EQ(123, sidecar.blockLength(10));
+    EXPECT_EQ(oneshot(data), sidecar.fileCrc());
+    EXPECT_TRUE(sidecar.matchesFile(fd));
+    close(fd);
+
+    ASSERT_TRUE(sidecar.write(Crc32cSidecar::sidecarPath("data")));
+    Crc32cSidecar copy;
+    ASSERT_TRUE(copy.read("data.crc32c"));
+    EXPECT_EQ(sidecar.blockSize(), copy.blockSize());
+    EXPECT_EQ(sidecar.fileLength(), copy.fileLength());
+    EXPECT_EQ(sidecar.mtimeNanos(), copy.mtimeNanos());
+    EXPECT_EQ(sidecar.fileCrc(), copy.fileCrc());
+    ASSERT_EQ(sidecar.numBlocks(), copy.numBlocks());
+    for (size_t i = 0; i < sidecar.numBlocks(); ++i) {
+        EXPECT_EQ(sidecar.blockCrc(i), copy.blockCrc(i));
+    }
+}
+
+TEST(Crc32cSidecar, EmptyFile) {
+    stupidunit::ChTempDir temp;
+    writeFile("empty", std::vector<char>());
+    int fd = open("empty", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    EXPECT_EQ(0, sidecar.numBlocks());
+    EXPECT_EQ(0, sidecar.fileCrc());
+
+    std::vector<size_t> badBlocks;
+    EXPECT_TRUE(sidecar.verify(fd, 0, 100, &badBlocks));
+    EXPECT_TRUE(badBlocks.empty());
+    close(fd);
+
+    ASSERT_TRUE(sidecar.write("empty.crc32c"));
+    EXPECT_TRUE(sidecar.read("empty.crc32c"));
+}
+
+TEST(Crc32cSidecar, Verify) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(8 * BLOCK_SIZE, 2);
+    writeFile("data", data);
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    close(fd);
+
+    // Corrupt one byte in block 5
+    overwriteByte("data", 5 * BLOCK_SIZE + 17, ~data[5 * BLOCK_SIZE + 17]);
+    fd = open("data", O_RDONLY);
+
+    std::vector<size_t> badBlocks;
+    EXPECT_TRUE(sidecar.verify(fd, 0, UINT64_MAX, &badBlocks));
+    ASSERT_EQ(1, badBlocks.size());
+    EXPECT_EQ(5, badBlocks[0]);
+
+    // Ranges that do not touch block 5 are fine
+    badBlocks.clear();
+    EXPECT_TRUE(sidecar.verify(fd, 0, 5 * BLOCK_SIZE, &badBlocks));
+    EXPECT_TRUE(sidecar.verify(fd, 6 * BLOCK_SIZE, BLOCK_SIZE, &badBlocks));
+    EXPECT_TRUE(badBlocks.empty());
+
+    // One byte in block 5 is enough
+    EXPECT_TRUE(sidecar.verify(fd, 6 * BLOCK_SIZE - 1, 1, &badBlocks));
+    EXPECT_EQ(1, badBlocks.size());
+    close(fd);
+}
+
+TEST(Crc32cSidecar, Truncated) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(4 * BLOCK_SIZE, 3);
+    writeFile("data", data);
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    close(fd);
+
+    truncate("data", 3 * BLOCK_SIZE + 10);
+    fd = open("data", O_RDONLY);
+    EXPECT_FALSE(sidecar.matchesFile(fd));
+    std::vector<size_t> badBlocks;
+    EXPECT_TRUE(sidecar.verify(fd, 0, UINT64_MAX, &badBlocks));
+    ASSERT_EQ(1, badBlocks.size());
+    EXPECT_EQ(3, badBlocks[0]);
+    close(fd);
+}
+
+TEST(Crc32cSidecar, CorruptSidecar) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(4 * BLOCK_SIZE, 4);
+    writeFile("data", data);
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    close(fd);
+    ASSERT_TRUE(sidecar.write("data.crc32c"));
+
+    Crc32cSidecar copy;
+    // Header and table corruption are both detected
+    static const off_t OFFSETS[] = { 0, 12, 20, 32, Crc32cSidecar::HEADER_SIZE + 5 };
+    for (size_t i = 0; i < sizeof(OFFSETS)/sizeof(*OFFSETS); ++i) {
+        ASSERT_TRUE(sidecar.write("data.crc32c"));
+        overwriteByte("data.crc32c", OFFSETS[i], 0x55);
+        EXPECT_FALSE(copy.read("data.crc32c"));
+        EXPECT_EQ(EINVAL, errno);
+    }
+
+    // Missing and truncated
+    EXPECT_FALSE(copy.read("missing.crc32c"));
+    EXPECT_EQ(ENOENT, errno);
+    ASSERT_TRUE(sidecar.write("data.crc32c"));
+    truncate("data.crc32c", Crc32cSidecar::HEADER_SIZE + 4);
+    EXPECT_FALSE(copy.read("data.crc32c"));
+}
+
+TEST(Crc32cSidecar, FailedReadKeepsContents) {
+    stupidunit::ChTempDir temp;
+    writeFile("data", makeData(4 * BLOCK_SIZE, 5));
+    int fd = open("data", O_RDONLY);
+    Crc32cSidecar sidecar;
+    ASSERT_TRUE(sidecar.compute(fd, BLOCK_SIZE));
+    close(fd);
+    ASSERT_TRUE(sidecar.write("data.crc32c"));
+
+    // A wrong file CRC under a valid header CRC is only caught by the last check
+    std::vector<char> contents(Crc32cSidecar::HEADER_SIZE + 4 * sidecar.numBlocks());
+    FILE* file = fopen("data.crc32c", "rb");
+    ASSERT_EQ(contents.size(), fread(&contents[0], 1, contents.size(), file));
+    fclose(file);
+    contents[32] ^= 1;
+    uint32_t headerCrc = crc32cFinish(crc32c(crc32cInit(), &contents[0], 44));
+    for (int i = 0; i < 4; ++i) contents[44 + i] = (char) (headerCrc >> (8 * i));
+    writeFile("data.crc32c", contents);
+
+    writeFile("other", makeData(BLOCK_SIZE + 1, 6));
+    fd = open("other", O_RDONLY);
+    Crc32cSidecar other;
+    ASSERT_TRUE(other.compute(fd, 2 * BLOCK_SIZE));
+    close(fd);
+    ASSERT_TRUE(other.write("other.crc32c"));
+
+    Crc32cSidecar copy;
+    ASSERT_TRUE(copy.read("other.crc32c"));
+    EXPECT_FALSE(copy.read("data.crc32c"));
+    EXPECT_EQ(EINVAL, errno);
+    EXPECT_EQ(2 * BLOCK_SIZE, copy.blockSize());
+    EXPECT_EQ(BLOCK_SIZE + 1, copy.fileLength());
+    EXPECT_EQ(other.mtimeNanos(), copy.mtimeNanos());
+    EXPECT_EQ(other.fileCrc(), copy.fileCrc());
+    ASSERT_EQ(1, copy.numBlocks());
+    EXPECT_EQ(other.blockCrc(0), copy.blockCrc(0));
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,73 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_state.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+TEST(Crc32cState, Step) {
+    std::vector<char> data = makeData(100000);
+    uint32_t expected = oneshot(data);
+    static const size_t STEPS[] = { 1, 7, 4096, 99999, 100000, 1 << 20 };
+    for (size_t i = 0; i < sizeof(STEPS)/sizeof(*STEPS); ++i) {
+        Crc32cState state(&data[0], data.size());
+        size_t calls = 0;
+        while (!state.step(STEPS[i])) {
+            calls += 1;
+            EXPECT_EQ(calls * STEPS[i], state.consumed());
+            EXPECT_EQ(data.size() - calls * STEPS[i], state.remaining());
+        }
+        EXPECT_EQ((data.size() - 1) / STEPS[i], calls);
+        EXPECT_EQ(expected, state.finish());
+        // Stepping when done does nothing
+        EXPECT_TRUE(state.step(100));
+        EXPECT_EQ(expected, state.finish());
+    }
+}
+
+TEST(Crc32cState, Feed) {
+    std::vector<char> data = makeData(10000);
+    Crc32cState state;
+    EXPECT_TRUE(state.done());
+    EXPECT_EQ(0, state.finish());
+    state.feed(&data[0], 3000);
+    EXPECT_FALSE(state.done());
+    EXPECT_TRUE(state.step(5000));
+    state.feed(&data[3000], 0);
+    EXPECT_TRUE(state.done());
+    state.feed(&data[3000], 7000);
+    while (!state.step(1000)) {}
+    EXPECT_EQ(10000, state.consumed());
+    EXPECT_EQ(oneshot(data), state.finish());
+
+    // Continuing an unfinished CRC
+    Crc32cState rest(&data[3000], 7000, crc32c(crc32cInit(), &data[0], 3000));
+    EXPECT_TRUE(rest.step(7000));
+    EXPECT_EQ(state.value(), rest.value());
+}
+
+TEST(Crc32cState, StepFor) {
+    std::vector<char> data = makeData(64 << 20);
+    Crc32cState state(&data[0], data.size());
+    // A zero budget still makes progress, one piece at a time
+    EXPECT_FALSE(state.stepFor(std::chrono::nanoseconds(0), 1000));
+    EXPECT_EQ(1000, state.consumed());
+
+    size_t calls = 0;
+    while (!state.stepFor(std::chrono::microseconds(100))) {
+        calls += 1;
+    }
+    // 64 MiB takes milliseconds, so the work was split across many calls
+    EXPECT_LT(1, calls);
+    EXPECT_EQ(oneshot(data), state.finish());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
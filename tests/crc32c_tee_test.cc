@@ -0,0 +1,120 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_tee.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+typedef std::vector<std::pair<uint64_t, uint32_t> > Checkpoints;
+
+static void recordCheckpoint(void* context, uint64_t offset, uint32_t crc) {
+    ((Checkpoints*) context)->push_back(std::make_pair(offset, crc));
+}
+
+static void writeAll(int fd, const std::vector<char>* data) {
+    // Uneven pieces, so the reader sees partial pipe contents
+    for (size_t offset = 0; offset < data->size(); ) {
+        size_t length = std::min((size_t) 70000, data->size() - offset);
+        ssize_t bytes = write(fd, &(*data)[offset], length);
+        if (bytes <= 0) break;
+        offset += bytes;
+    }
+    close(fd);
+}
+
+static void readAll(int fd, std::vector<char>* data) {
+    char buffer[65536];
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+        data->insert(data->end(), buffer, buffer + bytes);
+    }
+    close(fd);
+}
+
+static const uint64_t INTERVAL = 100000;
+
+static bool checkpointsMatch(const std::vector<char>& data, const Checkpoints& checkpoints) {
+    if (checkpoints.size() != data.size() / INTERVAL) return false;
+    for (size_t i = 0; i < checkpoints.size(); ++i) {
+        if (checkpoints[i].first != (i + 1) * INTERVAL ||
+                checkpoints[i].second != oneshot(&data[0], checkpoints[i].first)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(Crc32cTee, Pipes) {
+    std::vector<char> data = makeData(3000000);
+    int in[2];
+    int out[2];
+    ASSERT_EQ(0, pipe(in));
+    ASSERT_EQ(0, pipe(out));
+    std::thread writer(writeAll, in[1], &data);
+    std::vector<char> copy;
+    std::thread reader(readAll, out[0], &copy);
+
+    uint32_t crc;
+    uint64_t length;
+    Checkpoints checkpoints;
+    EXPECT_TRUE(crc32cTee(in[0], out[1], &crc, &length, INTERVAL, &recordCheckpoint,
+            &checkpoints));
+    close(in[0]);
+    close(out[1]);
+    writer.join();
+    reader.join();
+
+    EXPECT_EQ(data.size(), length);
+    EXPECT_EQ(oneshot(&data[0], data.size()), crc);
+    EXPECT_TRUE(data == copy);
+    EXPECT_TRUE(checkpointsMatch(data, checkpoints));
+}
+
+TEST(Crc32cTee, Files) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(2500000);
+    int fd = open("in", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    writeAll(fd, &data);
+
+    int in = open("in", O_RDONLY);
+    int out = open("out", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    uint32_t crc;
+    uint64_t length;
+    Checkpoints checkpoints;
+    EXPECT_TRUE(crc32cTee(in, out, &crc, &length, INTERVAL, &recordCheckpoint, &checkpoints));
+    close(in);
+    close(out);
+
+    EXPECT_EQ(data.size(), length);
+    EXPECT_EQ(oneshot(&data[0], data.size()), crc);
+    std::vector<char> copy;
+    readAll(open("out", O_RDONLY), &copy);
+    EXPECT_TRUE(data == copy);
+    EXPECT_TRUE(checkpointsMatch(data, checkpoints));
+
+    // Empty input, no checkpoints
+    truncate("in", 0);
+    in = open("in", O_RDONLY);
+    out = open("out", O_WRONLY | O_TRUNC);
+    EXPECT_TRUE(crc32cTee(in, out, &crc, &length));
+    EXPECT_EQ(0, length);
+    EXPECT_EQ(0, crc);
+    close(in);
+    close(out);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -2,10 +2,14 @@
 // All rights reserved. Use of this source code is governed by a
 // BSD-style license that can be found in the LICENSE file.
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstring>
+#include <vector>
 
 #include "crc32c.h"
+#include "tests/crc32c_test_util.h"
 #include "tests/stupidunit.h"
 
 using namespace logging;
@@ -140,6 +144,148 @@ TEST(CRC32C, Alignment) {
     }
 }
 
+TEST(CRC32C, Patch) {
+    // Large enough to use most of the shift table
+    std::vector<char> data = makeData(3 << 20, 1);
+    std::vector<char> replacement = makeData(1000, 2);
+    uint32_t crc = oneshot(data);
+
+    static const size_t OFFSETS[] = { 0, 1, 4095, 1 << 20, (3 << 20) - 1000 };
+    static const size_t LENGTHS[] = { 0, 1, 3, 8, 257, 1000 };
+    for (size_t i = 0; i < sizeof(OFFSETS)/sizeof(*OFFSETS); ++i) {
+        for (size_t j = 0; j < sizeof(LENGTHS)/sizeof(*LENGTHS); ++j) {
+            size_t offset = OFFSETS[i];
+            size_t length = LENGTHS[j];
+            std::vector<char> patched(data);
+            memcpy(&patched[offset], &replacement[0], length);
+
+            uint32_t expected = oneshot(patched);
+            uint32_t actual = crc32cPatch(crc, data.size(), offset, &data[offset],
+                    &replacement[0], length);
+            if (expected != actual) {
+                printf("Patch offset %zu length %zu expected 0x%08x actual 0x%08x\n",
+                        offset, length, expected, actual);
+            }
+            EXPECT_EQ(expected, actual);
+
+            // Unfinished CRCs work the same way
+            uint32_t unfinished = crc32cPatch(crc32cFinish(crc), data.size(), offset,
+                    &data[offset], &replacement[0], length);
+            EXPECT_EQ(expected, crc32cFinish(unfinished));
+        }
+    }
+}
+
+TEST(CRC32C, RemovePrefixSuffix) {
+    std::vector<char> data = makeData(1 << 20, 3);
+    uint32_t crcAB = oneshot(data);
+
+    static const size_t SPLITS[] = { 0, 1, 7, 4096, 999999, 1 << 20 };
+    for (size_t i = 0; i < sizeof(SPLITS)/sizeof(*SPLITS); ++i) {
+        size_t lengthA = SPLITS[i];
+        size_t lengthB = data.size() - lengthA;
+        uint32_t crcA = oneshot(&data[0], lengthA);
+        uint32_t crcB = oneshot(&data[lengthA], lengthB);
+
+        EXPECT_EQ(crcB, crc32cRemovePrefix(crcAB, crcA, lengthB));
+        EXPECT_EQ(crcA, crc32cRemoveSuffix(crcAB, crcB, lengthB));
+        EXPECT_EQ(crcA, crc32cRemoveSuffixData(crcAB, &data[lengthA], lengthB));
+    }
+}
+
+TEST(CRC32C, DetectZeros) {
+    static const size_t SUB_BLOCK = 512;
+    // 20 full pieces and a short one; pieces 0, 3, 4, 19 and 20 are zero, and piece 7 is zero
+    // except for its last byte
+    std::vector<char> data = makeData(20 * SUB_BLOCK + 100, 7);
+    static const size_t ZERO_BLOCKS[] = { 0, 3, 4, 19, 20 };
+    for (size_t i = 0; i < sizeof(ZERO_BLOCKS)/sizeof(*ZERO_BLOCKS); ++i) {
+        size_t start = ZERO_BLOCKS[i] * SUB_BLOCK;
+        std::fill(data.begin() + start, data.begin() + std::min(start + SUB_BLOCK, data.size()), 0);
+    }
+    std::fill(data.begin() + 7 * SUB_BLOCK, data.begin() + 8 * SUB_BLOCK - 1, 0);
+
+    uint8_t bitmap[3] = { 0xff, 0xff, 0xff };
+    int allZero = 1;
+    uint32_t crc = crc32cDetectZeros(crc32cInit(), &data[0], data.size(), SUB_BLOCK, bitmap,
+            &allZero);
+    EXPECT_EQ(oneshot(data), crc32cFinish(crc));
+    EXPECT_EQ(0, allZero);
+    EXPECT_EQ(0x19, bitmap[0]);
+    EXPECT_EQ(0x00, bitmap[1]);
+    EXPECT_EQ(0x18, bitmap[2] & 0x1f);
+
+    // All zeros, as one piece and as many
+    std::vector<char> zeros(10000, 0);
+    crc = crc32cDetectZeros(crc32cInit(), &zeros[0], zeros.size(), 0, NULL, &allZero);
+    EXPECT_EQ(oneshot(zeros), crc32cFinish(crc));
+    EXPECT_EQ(1, allZero);
+    crc = crc32cDetectZeros(crc32cInit(), &zeros[0], zeros.size(), 4096, NULL, &allZero);
+    EXPECT_EQ(oneshot(zeros), crc32cFinish(crc));
+    EXPECT_EQ(1, allZero);
+
+    // Continues a previous CRC
+    crc = crc32c(crc32cInit(), &data[0], 10);
+    crc = crc32cDetectZeros(crc, &data[10], data.size() - 10, 100, NULL, NULL);
+    EXPECT_EQ(oneshot(data), crc32cFinish(crc));
+}
+
+TEST(CRC32C, Column) {
+    // Lengths around the unrolled block of 8
+    static const size_t COUNT = 37;
+    uint64_t values[COUNT];
+    uint64_t x = 1;
+    for (size_t i = 0; i < COUNT; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        values[i] = x;
+    }
+    uint32_t values32[COUNT];
+    memcpy(values32, values, sizeof(values32));
+
+    static const uint32_t SEEDS[] = { crc32cInit(), 0, 0x12345678 };
+    for (size_t s = 0; s < sizeof(SEEDS)/sizeof(*SEEDS); ++s) {
+        for (size_t count = 0; count <= COUNT; count += 9) {
+            uint32_t out[COUNT + 1];
+            out[count] = 0xdeadbeef;
+            crc32cColumnU32(values32, out, count, SEEDS[s]);
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(crc32cSarwate(SEEDS[s], &values32[i], 4), out[i]);
+            }
+            crc32cColumnU64(values, out, count, SEEDS[s]);
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(crc32cSarwate(SEEDS[s], &values[i], 8), out[i]);
+            }
+            // Nothing past the end is written
+            EXPECT_EQ(0xdeadbeef, out[count]);
+        }
+    }
+}
+
+TEST(CRC32C, Strided) {
+    std::vector<char> image(64 * 200);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = (char) (i * 31 + (i >> 7));
+    }
+    static const size_t ROW_BYTES[] = { 0, 1, 7, 8, 13, 64 };
+    static const size_t PITCH = 200;
+    for (size_t r = 0; r < sizeof(ROW_BYTES)/sizeof(*ROW_BYTES); ++r) {
+        size_t rowBytes = ROW_BYTES[r];
+        for (size_t rows = 0; rows <= 64; rows += 21) {
+            // Gather the rectangle at column 5
+            std::vector<char> gathered;
+            for (size_t row = 0; row < rows; ++row) {
+                const char* p = &image[row * PITCH + 5];
+                gathered.insert(gathered.end(), p, p + rowBytes);
+            }
+            uint32_t expected = crc32c(0x1234, gathered.data(), gathered.size());
+            EXPECT_EQ(expected, crc32cStrided(0x1234, &image[5], rowBytes, PITCH, rows));
+        }
+    }
+    // Contiguous rows
+    EXPECT_EQ(crc32c(crc32cInit(), &image[0], 6400),
+            crc32cStrided(crc32cInit(), &image[0], 100, 100, 64));
+}
+
 int main() {
     return TestSuite::globalInstance()->runAll();
 }
@@ -0,0 +1,36 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Data and reference CRCs shared by the CRC32C tests.
+
+#ifndef LOGGING_TESTS_CRC32C_TEST_UTIL_H__
+#define LOGGING_TESTS_CRC32C_TEST_UTIL_H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "crc32c.h"
+
+// Returns length pseudo-random bytes. The same seed always gives the same bytes.
+static inline std::vector<char> makeData(size_t length, uint32_t seed = 1) {
+    std::vector<char> data(length);
+    uint32_t x = seed;
+    for (size_t i = 0; i < length; ++i) {
+        x = x * 1103515245 + 12345;
+        data[i] = (char) (x >> 16);
+    }
+    return data;
+}
+
+// Returns the finished CRC32C of data, computed in one call.
+static inline uint32_t oneshot(const char* data, size_t length) {
+    return logging::crc32cFinish(logging::crc32c(logging::crc32cInit(), data, length));
+}
+
+static inline uint32_t oneshot(const std::vector<char>& data) {
+    return oneshot(data.data(), data.size());
+}
+
+#endif
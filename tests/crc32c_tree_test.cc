@@ -0,0 +1,157 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_cache.h"
+#include "crc32c_tree.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+struct ExpectedFile {
+    std::string path;
+    std::vector<char> data;
+};
+
+static void writeFile(const std::string& path, const std::vector<char>& data) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (!data.empty()) write(fd, &data[0], data.size());
+    close(fd);
+}
+
+// Creates a tree with files of many sizes and returns them in sorted depth first order.
+static std::vector<ExpectedFile> makeTree() {
+    mkdir("tree", 0777);
+    mkdir("tree/b", 0777);
+    mkdir("tree/b/deep", 0777);
+    mkdir("tree/empty_dir", 0777);
+    static const char* const PATHS[] = {
+        "tree/a", "tree/b/deep/x", "tree/b/y", "tree/c_large", "tree/d_empty", "tree/z",
+    };
+    static const size_t LENGTHS[] = { 100, 5000, 1, 1000000, 0, 300000 };
+    std::vector<ExpectedFile> files;
+    for (size_t i = 0; i < sizeof(PATHS)/sizeof(*PATHS); ++i) {
+        ExpectedFile file;
+        file.path = PATHS[i];
+        file.data = makeData(LENGTHS[i], (uint32_t) i + 1);
+        writeFile(file.path, file.data);
+        files.push_back(file);
+    }
+    // Skipped
+    symlink("a", "tree/symlink");
+    return files;
+}
+
+static std::vector<Crc32cTreeResult> checksumTree(Crc32cTreeChecksummer* checksummer,
+        const std::string& root) {
+    std::vector<Crc32cTreeResult> results;
+    checksummer->run(root, [&results](const Crc32cTreeResult& result) {
+        results.push_back(result);
+    });
+    return results;
+}
+
+static bool resultsMatch(const std::vector<Crc32cTreeResult>& results,
+        const std::vector<ExpectedFile>& files) {
+    if (results.size() != files.size()) return false;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const std::vector<char>& data = files[i].data;
+        uint32_t crc = oneshot(data);
+        if (results[i].path != files[i].path || results[i].error != 0 ||
+                results[i].length != data.size() || results[i].crc != crc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(Crc32cTree, Tree) {
+    stupidunit::ChTempDir temp;
+    std::vector<ExpectedFile> files = makeTree();
+
+    // Small ranges so the large files are split; tight limits on open and pending files
+    static const int THREADS[] = { 1, 2, 8 };
+    for (size_t i = 0; i < sizeof(THREADS)/sizeof(*THREADS); ++i) {
+        Crc32cTreeChecksummer checksummer(THREADS[i], 65536);
+        EXPECT_TRUE(resultsMatch(checksumTree(&checksummer, "tree"), files));
+        Crc32cTreeChecksummer limited(THREADS[i], 10000, 1, 1);
+        EXPECT_TRUE(resultsMatch(checksumTree(&limited, "tree"), files));
+    }
+    Crc32cTreeChecksummer checksummer(4);
+    EXPECT_TRUE(resultsMatch(checksumTree(&checksummer, "tree"), files));
+}
+
+TEST(Crc32cTree, ManyFiles) {
+    stupidunit::ChTempDir temp;
+    mkdir("tree", 0777);
+    std::vector<ExpectedFile> files;
+    for (int i = 0; i < 500; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "tree/%04d", i);
+        ExpectedFile file;
+        file.path = name;
+        file.data = makeData(i * 97 % 20000, i);
+        writeFile(file.path, file.data);
+        files.push_back(file);
+    }
+    Crc32cTreeChecksummer checksummer(8, 4096, 16, 32);
+    EXPECT_TRUE(resultsMatch(checksumTree(&checksummer, "tree"), files));
+}
+
+TEST(Crc32cTree, RootFile) {
+    stupidunit::ChTempDir temp;
+    std::vector<ExpectedFile> files = makeTree();
+    Crc32cTreeChecksummer checksummer(2, 65536);
+    std::vector<ExpectedFile> large(files.begin() + 3, files.begin() + 4);
+    EXPECT_TRUE(resultsMatch(checksumTree(&checksummer, "tree/c_large"), large));
+
+    std::vector<Crc32cTreeResult> results;
+    EXPECT_FALSE(checksummer.run("missing", [&results](const Crc32cTreeResult& result) {
+        results.push_back(result);
+    }));
+    EXPECT_EQ(ENOENT, errno);
+    EXPECT_TRUE(results.empty());
+}
+
+TEST(Crc32cTree, Cache) {
+    stupidunit::ChTempDir temp;
+    std::vector<ExpectedFile> files = makeTree();
+    // No racy window, so the files just written are cached
+    Crc32cCache cache(0);
+    ASSERT_TRUE(cache.open("cache"));
+    Crc32cTreeChecksummer checksummer(4, 65536);
+    checksummer.setCache(&cache);
+    EXPECT_TRUE(resultsMatch(checksumTree(&checksummer, "tree"), files));
+
+    // Every file was stored
+    for (size_t i = 0; i < files.size(); ++i) {
+        struct stat st;
+        ASSERT_EQ(0, stat(files[i].path.c_str(), &st));
+        uint32_t crc;
+        EXPECT_TRUE(cache.lookup(st, &crc));
+    }
+
+    // A cached CRC is reported without reading the file
+    struct stat st;
+    ASSERT_EQ(0, stat("tree/z", &st));
+    ASSERT_TRUE(cache.insert(st, 0x12345678));
+    std::vector<Crc32cTreeResult> results = checksumTree(&checksummer, "tree");
+    ASSERT_EQ(files.size(), results.size());
+    EXPECT_EQ("tree/z", results.back().path);
+    EXPECT_EQ(0x12345678, results.back().crc);
+    EXPECT_EQ(files.back().data.size(), results.back().length);
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
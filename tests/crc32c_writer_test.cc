@@ -0,0 +1,148 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_writer.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static std::vector<char> readFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    std::vector<char> contents;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+        contents.insert(contents.end(), buffer, buffer + bytes);
+    }
+    close(fd);
+    return contents;
+}
+
+static const size_t BUFFER_SIZE = 4096;
+static const uint32_t INTERVAL = 1000;
+
+TEST(Crc32cWriter, WriteSizes) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(100000);
+    // Small writes, writes that span the buffer, and writes larger than it
+    static const size_t LENGTHS[] = { 1, 100, 4000, 5000, 0, 3, 10000, 4096, 17 };
+
+    int fd = open("out", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    Crc32cWriter writer(fd, INTERVAL, BUFFER_SIZE);
+    size_t offset = 0;
+    for (size_t i = 0; offset < 90000; i = (i + 1) % (sizeof(LENGTHS)/sizeof(*LENGTHS))) {
+        ASSERT_TRUE(writer.write(&data[offset], LENGTHS[i]));
+        offset += LENGTHS[i];
+        EXPECT_EQ(offset, writer.length());
+    }
+    EXPECT_EQ(oneshot(&data[0], offset), writer.crc());
+    ASSERT_EQ(offset / INTERVAL, writer.checkpoints().size());
+    for (size_t i = 0; i < writer.checkpoints().size(); ++i) {
+        EXPECT_EQ(oneshot(&data[0], (i + 1) * INTERVAL), writer.checkpoints()[i]);
+    }
+    ASSERT_TRUE(writer.finish());
+    close(fd);
+
+    std::vector<char> contents = readFile("out");
+    Crc32cTrailer trailer;
+    fd = open("out", O_RDONLY);
+    ASSERT_TRUE(trailer.read(fd));
+    close(fd);
+    EXPECT_EQ(offset, trailer.dataLength);
+    EXPECT_EQ(INTERVAL, trailer.checkpointInterval);
+    EXPECT_EQ(writer.crc(), trailer.crc);
+    EXPECT_TRUE(writer.checkpoints() == trailer.checkpoints);
+    ASSERT_EQ(offset + trailer.size(), contents.size());
+    EXPECT_EQ(0, memcmp(&data[0], &contents[0], offset));
+}
+
+TEST(Crc32cWriter, NoCheckpoints) {
+    stupidunit::ChTempDir temp;
+    int fd = open("out", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    Crc32cWriter writer(fd);
+    ASSERT_TRUE(writer.write("hello", 5));
+    ASSERT_TRUE(writer.flush());
+    ASSERT_TRUE(writer.finish());
+    close(fd);
+    EXPECT_EQ(0, writer.checkpoints().size());
+
+    fd = open("out", O_RDONLY);
+    Crc32cTrailer trailer;
+    ASSERT_TRUE(trailer.read(fd));
+    close(fd);
+    EXPECT_EQ(5, trailer.dataLength);
+    EXPECT_EQ(oneshot("hello", 5), trailer.crc);
+    EXPECT_EQ(5 + Crc32cTrailer::FOOTER_SIZE, readFile("out").size());
+}
+
+TEST(Crc32cWriter, CorruptTrailer) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(5000);
+    int fd = open("out", O_RDWR | O_CREAT | O_TRUNC, 0666);
+    Crc32cWriter writer(fd, INTERVAL, BUFFER_SIZE);
+    ASSERT_TRUE(writer.write(&data[0], data.size()));
+    ASSERT_TRUE(writer.finish());
+
+    Crc32cTrailer trailer;
+    ASSERT_TRUE(trailer.read(fd));
+    off_t size = lseek(fd, 0, SEEK_END);
+    // Corrupt a checkpoint, then the footer
+    static const off_t OFFSETS[] = { 5002, size - 20 };
+    for (size_t i = 0; i < sizeof(OFFSETS)/sizeof(*OFFSETS); ++i) {
+        char byte;
+        pread(fd, &byte, 1, OFFSETS[i]);
+        byte ^= 1;
+        pwrite(fd, &byte, 1, OFFSETS[i]);
+        EXPECT_FALSE(trailer.read(fd));
+        EXPECT_EQ(EINVAL, errno);
+    }
+
+    ftruncate(fd, 10);
+    EXPECT_FALSE(trailer.read(fd));
+    close(fd);
+}
+
+TEST(Crc32cWriter, FailedWrite) {
+    stupidunit::ChTempDir temp;
+    std::vector<char> data = makeData(5000);
+    int fd = open("out", O_RDWR | O_CREAT | O_TRUNC, 0666);
+    close(fd);
+    fd = open("out", O_RDONLY);
+
+    // A failed large write is not counted, and the writer stays failed
+    Crc32cWriter writer(fd, INTERVAL, BUFFER_SIZE);
+    ASSERT_TRUE(writer.write(&data[0], 10));
+    EXPECT_FALSE(writer.write(&data[10], 2 * BUFFER_SIZE));
+    EXPECT_EQ(EBADF, errno);
+    EXPECT_EQ(10, writer.length());
+    EXPECT_EQ(oneshot(&data[0], 10), writer.crc());
+    errno = 0;
+    EXPECT_FALSE(writer.write(&data[0], 1));
+    EXPECT_EQ(EBADF, errno);
+    EXPECT_FALSE(writer.flush());
+    EXPECT_FALSE(writer.finish());
+    EXPECT_EQ(10, writer.length());
+
+    // A failed flush
+    Crc32cWriter flushed(fd, INTERVAL, BUFFER_SIZE);
+    ASSERT_TRUE(flushed.write(&data[0], 10));
+    EXPECT_FALSE(flushed.flush());
+    EXPECT_FALSE(flushed.finish());
+    EXPECT_EQ(EBADF, errno);
+    close(fd);
+    EXPECT_EQ(0, readFile("out").size());
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc_engine.h"
+#include "tests/cycletimer.h"
+
+using namespace logging;
+
+static const int TRIALS = 5;
+
+// Computes the CRC32C and the CRC-32 of data with two calls, one pass each.
+static void separate(const char* data, size_t length, uint32_t* crcC, uint32_t* crcIeee) {
+    *crcC = crc32c(crc32cInit(), data, length);
+    *crcIeee = (uint32_t) CrcEngine::crc32().update(CrcEngine::crc32().init(), data, length);
+}
+
+// Computes both in one pass.
+static void dual(const char* data, size_t length, uint32_t* crcC, uint32_t* crcIeee) {
+    *crcC = crc32cInit();
+    *crcIeee = (uint32_t) CrcEngine::crc32().init();
+    CrcEngine::updateCrc32cAndCrc32(crcC, crcIeee, data, length);
+}
+
+typedef void (*DualFunction)(const char* data, size_t length, uint32_t* crcC, uint32_t* crcIeee);
+
+// Returns false if function computes the wrong CRCs.
+static bool runTest(const char* name, DualFunction function, const std::vector<char>& buffer,
+        size_t length) {
+    uint32_t expectedC;
+    uint32_t expectedIeee;
+    separate(&buffer[0], length, &expectedC, &expectedIeee);
+    printf("%s,%zu", name, length);
+    // Walk through the buffer so buffers larger than the cache are read from memory
+    size_t offset = 0;
+    for (int j = 0; j < TRIALS; ++j) {
+        if (offset + length > buffer.size()) offset = 0;
+        uint32_t crcC;
+        uint32_t crcIeee;
+        CycleTimer timer;
+        timer.start();
+        function(&buffer[offset], length, &crcC, &crcIeee);
+        timer.end();
+        printf(",%d", timer.getCycles());
+        if (offset == 0 && (crcC != expectedC || crcIeee != expectedIeee)) {
+            fprintf(stderr, "%s,%zu: wrong CRCs 0x%08x 0x%08x, expected 0x%08x 0x%08x\n",
+                    name, length, crcC, crcIeee, expectedC, expectedIeee);
+            return false;
+        }
+        offset += length;
+    }
+    printf("\n");
+    return true;
+}
+
+int main() {
+    static const size_t LENGTHS[] = { 256, 4096, 65536, 1 << 20, 16 << 20 };
+    std::vector<char> buffer(6 * (16 << 20));
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = (char) (i * 7 + (i >> 12));
+    }
+    // Touch the CRC-32 tables
+    CrcEngine::crc32();
+
+    printf("function,length,cycles...\n");
+    for (size_t i = 0; i < sizeof(LENGTHS)/sizeof(*LENGTHS); ++i) {
+        if (!runTest("separate", separate, buffer, LENGTHS[i]) ||
+                !runTest("dual", dual, buffer, LENGTHS[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
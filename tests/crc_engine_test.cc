@@ -0,0 +1,101 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <cstring>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc_engine.h"
+#include "tests/crc32c_test_util.h"
+#include "tests/stupidunit.h"
+
+using namespace logging;
+
+static const CrcEngine* const ENGINES[] = {
+    &CrcEngine::crc32(), &CrcEngine::crc32c(), &CrcEngine::crc64Xz(), &CrcEngine::crc64Nvme(),
+};
+static const size_t NUM_ENGINES = sizeof(ENGINES)/sizeof(*ENGINES);
+
+TEST(CrcEngine, CheckValues) {
+    // The catalogued CRC of "123456789" for each polynomial
+    const char* check = "123456789";
+    EXPECT_EQ(0xcbf43926, CrcEngine::crc32().checksum(check, 9));
+    EXPECT_EQ(0xe3069283, CrcEngine::crc32c().checksum(check, 9));
+    EXPECT_EQ(0x995dc9bbdf1939faULL, CrcEngine::crc64Xz().checksum(check, 9));
+    EXPECT_EQ(0xae8b14860a799888ULL, CrcEngine::crc64Nvme().checksum(check, 9));
+    // A 16 bit CRC from its polynomial: CRC-16/X-25 has the same init and final XOR
+    CrcEngine crc16(16, 0x8408);
+    EXPECT_EQ(0x906e, crc16.checksum(check, 9));
+    EXPECT_EQ(0, crc16.checksum(check, 0));
+}
+
+TEST(CrcEngine, Kernels) {
+    std::vector<char> data = makeData(2000);
+    for (size_t e = 0; e < NUM_ENGINES; ++e) {
+        const CrcEngine& engine = *ENGINES[e];
+        // Byte at a time, the reference
+        uint64_t reference = engine.init();
+        for (size_t length = 0; length <= 1000; ++length) {
+            const char* p = &data[length % 7];
+            if (length > 0) reference = engine.updateSlicing(engine.init(), p, length);
+            EXPECT_EQ(reference, engine.update(engine.init(), p, length));
+            if (engine.hasFolding() && length >= CrcEngine::FOLD_MIN_LENGTH) {
+                EXPECT_EQ(reference, engine.updateFolding(engine.init(), p, length));
+                // Folding with a non-initial register
+                EXPECT_EQ(engine.updateSlicing(0x1234567, p, length),
+                        engine.updateFolding(0x1234567, p, length));
+            }
+        }
+    }
+    // The slicing kernel matches crc32c() for the same polynomial
+    EXPECT_EQ(crc32c(crc32cInit(), &data[3], 1234),
+            CrcEngine::crc32c().updateSlicing(crc32cInit(), &data[3], 1234));
+    CrcEngine castagnoli(32, 0x82f63b78);
+    EXPECT_EQ(crc32c(crc32cInit(), &data[0], 1000),
+            castagnoli.update(crc32cInit(), &data[0], 1000));
+}
+
+TEST(CrcEngine, Combine) {
+    std::vector<char> data = makeData(100000);
+    static const size_t SPLITS[] = { 0, 1, 63, 64, 4096, 50000, 99999, 100000 };
+    for (size_t e = 0; e < NUM_ENGINES; ++e) {
+        const CrcEngine& engine = *ENGINES[e];
+        uint64_t whole = engine.checksum(&data[0], data.size());
+        for (size_t i = 0; i < sizeof(SPLITS)/sizeof(*SPLITS); ++i) {
+            size_t split = SPLITS[i];
+            uint64_t a = engine.checksum(&data[0], split);
+            uint64_t b = engine.checksum(&data[split], data.size() - split);
+            EXPECT_EQ(whole, engine.combine(a, b, data.size() - split));
+        }
+
+        // Shifting an unfinished CRC appends zeros
+        std::vector<char> zeros(5000);
+        uint64_t crc = engine.update(engine.init(), &data[0], 100);
+        EXPECT_EQ(engine.update(crc, &zeros[0], zeros.size()),
+                engine.shift(crc, engine.shiftOperator(zeros.size())));
+    }
+}
+
+TEST(CrcEngine, Crc32cAndCrc32) {
+    std::vector<char> data = makeData(10000);
+    static const size_t LENGTHS[] = { 0, 1, 63, 64, 65, 80, 127, 128, 200, 1000, 9999 };
+    for (size_t i = 0; i < sizeof(LENGTHS)/sizeof(*LENGTHS); ++i) {
+        size_t length = LENGTHS[i];
+        uint32_t crcC = crc32cInit();
+        uint32_t crcIeee = (uint32_t) CrcEngine::crc32().init();
+        CrcEngine::updateCrc32cAndCrc32(&crcC, &crcIeee, &data[1], length);
+        EXPECT_EQ(crc32c(crc32cInit(), &data[1], length), crcC);
+        EXPECT_EQ(CrcEngine::crc32().update(CrcEngine::crc32().init(), &data[1], length), crcIeee);
+
+        // Continuing both registers
+        CrcEngine::updateCrc32cAndCrc32(&crcC, &crcIeee, &data[1 + length], 777);
+        EXPECT_EQ(crc32c(crc32cInit(), &data[1], length + 777), crcC);
+        EXPECT_EQ(CrcEngine::crc32().checksum(&data[1], length + 777),
+                CrcEngine::crc32().finish(crcIeee));
+    }
+}
+
+int main() {
+    return TestSuite::globalInstance()->runAll();
+}
@@ -0,0 +1,207 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Command line tool: prints the CRC32C of files, and writes or checks block CRC sidecar files.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crc32c.h"
+#include "crc32c_cache.h"
+#include "crc32c_file.h"
+#include "crc32c_sidecar.h"
+#include "crc32c_tree.h"
+
+using namespace logging;
+
+static void usage() {
+    fprintf(stderr,
+            "usage: crc32c [-C CACHE] [-j THREADS] [FILE...]\n"
+            "       crc32c -w [-b BLOCK_SIZE] FILE...\n"
+            "       crc32c -c [-r OFFSET:LENGTH] FILE...\n"
+            "\n"
+            "Prints the CRC32C of each FILE, or of standard input. Directories are checksummed\n"
+            "recursively.\n"
+            "  -C  look up and store the CRCs of unchanged files in the cache file CACHE\n"
+            "  -j  number of threads for directories (default: the number of CPUs)\n"
+            "  -w  also write per-block CRCs to the sidecar file FILE.crc32c\n"
+            "  -b  sidecar block size in bytes (default %u)\n"
+            "  -c  verify FILE against FILE.crc32c, reading only the blocks in the range\n"
+            "  -r  range to verify (default: the whole file)\n",
+            Crc32cSidecar::DEFAULT_BLOCK_SIZE);
+    exit(2);
+}
+
+static bool isDirectory(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool checksumFile(const char* path, Crc32cCache* cache) {
+    int fd = open(path, O_RDONLY);
+    uint32_t crc;
+    if (fd < 0 || !crc32cFileCached(fd, cache, &crc)) {
+        fprintf(stderr, "crc32c: %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    close(fd);
+    printf("%08x  %s\n", crc, path);
+    return true;
+}
+
+static bool checksumTree(const char* path, int threads, Crc32cCache* cache) {
+    Crc32cTreeChecksummer checksummer(threads);
+    checksummer.setCache(cache);
+    bool success = true;
+    bool found = checksummer.run(path, [&success](const Crc32cTreeResult& result) {
+        if (result.error != 0) {
+            fprintf(stderr, "crc32c: %s: %s\n", result.path.c_str(), strerror(result.error));
+            success = false;
+        } else {
+            printf("%08x  %s\n", result.crc, result.path.c_str());
+        }
+    });
+    if (!found) {
+        fprintf(stderr, "crc32c: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    return success;
+}
+
+static bool writeSidecar(const char* path, uint32_t blockSize) {
+    int fd = open(path, O_RDONLY);
+    Crc32cSidecar sidecar;
+    std::string sidecarPath = Crc32cSidecar::sidecarPath(path);
+    if (fd < 0 || !sidecar.compute(fd, blockSize) || !sidecar.write(sidecarPath)) {
+        fprintf(stderr, "crc32c: %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    close(fd);
+    printf("%08x  %s\n", sidecar.fileCrc(), path);
+    return true;
+}
+
+static bool checkSidecar(const char* path, uint64_t offset, uint64_t length) {
+    Crc32cSidecar sidecar;
+    std::string sidecarPath = Crc32cSidecar::sidecarPath(path);
+    if (!sidecar.read(sidecarPath)) {
+        fprintf(stderr, "crc32c: %s: %s\n", sidecarPath.c_str(), strerror(errno));
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "crc32c: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    if (!sidecar.matchesFile(fd)) {
+        fprintf(stderr, "crc32c: %s: warning: size or mtime differs from %s\n", path,
+                sidecarPath.c_str());
+    }
+
+    std::vector<size_t> badBlocks;
+    bool success = sidecar.verify(fd, offset, length, &badBlocks);
+    if (!success) {
+        fprintf(stderr, "crc32c: %s: %s\n", path, strerror(errno));
+    }
+    close(fd);
+    if (!success) return false;
+
+    for (size_t i = 0; i < badBlocks.size(); ++i) {
+        uint64_t blockOffset = sidecar.blockOffset(badBlocks[i]);
+        printf("%s: block %zu bytes %" PRIu64 "-%" PRIu64 " FAILED\n", path, badBlocks[i],
+                blockOffset, blockOffset + sidecar.blockLength(badBlocks[i]));
+    }
+    printf("%s: %s\n", path, badBlocks.empty() ? "OK" : "FAILED");
+    return badBlocks.empty();
+}
+
+int main(int argc, char* argv[]) {
+    bool write = false;
+    bool check = false;
+    uint32_t blockSize = Crc32cSidecar::DEFAULT_BLOCK_SIZE;
+    uint64_t offset = 0;
+    uint64_t length = UINT64_MAX;
+    const char* cachePath = NULL;
+    int threads = (int) std::thread::hardware_concurrency();
+
+    int option;
+    while ((option = getopt(argc, argv, "wcb:r:C:j:")) != -1) {
+        char* end;
+        switch (option) {
+            case 'w':
+                write = true;
+                break;
+            case 'c':
+                check = true;
+                break;
+            case 'b':
+                blockSize = (uint32_t) strtoul(optarg, &end, 0);
+                if (*end != '\0' || blockSize == 0) usage();
+                break;
+            case 'r':
+                offset = strtoull(optarg, &end, 0);
+                if (end == optarg || *end != ':') usage();
+                {
+                    const char* start = end + 1;
+                    length = strtoull(start, &end, 0);
+                    if (end == start || *end != '\0') usage();
+                }
+                break;
+            case 'C':
+                cachePath = optarg;
+                break;
+            case 'j':
+                threads = (int) strtol(optarg, &end, 10);
+                if (*end != '\0' || threads < 1) usage();
+                break;
+            default:
+                usage();
+        }
+    }
+    if (write && check) usage();
+
+    Crc32cCache cache;
+    if (cachePath != NULL && !cache.open(cachePath)) {
+        fprintf(stderr, "crc32c: %s: %s\n", cachePath, strerror(errno));
+        return 1;
+    }
+
+    if (optind == argc) {
+        if (write || check) usage();
+        uint32_t crc;
+        if (!crc32cFile(STDIN_FILENO, &crc)) {
+            fprintf(stderr, "crc32c: stdin: %s\n", strerror(errno));
+            return 1;
+        }
+        printf("%08x  -\n", crc);
+        return 0;
+    }
+
+    bool success = true;
+    for (int i = optind; i < argc; ++i) {
+        if (write) {
+            success &= writeSidecar(argv[i], blockSize);
+        } else if (check) {
+            success &= checkSidecar(argv[i], offset, length);
+        } else if (isDirectory(argv[i])) {
+            success &= checksumTree(argv[i], threads, cachePath != NULL ? &cache : NULL);
+        } else {
+            success &= checksumFile(argv[i], cachePath != NULL ? &cache : NULL);
+        }
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Computes the CRC32C of an object stored as shards from a manifest of shard lengths and CRCs,
+// without reading the shards, and checks it against the recorded object CRC.
+//
+//   crc32c-merge object.manifest
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "crc32c_manifest.h"
+
+using namespace logging;
+
+static void usage() {
+    fprintf(stderr,
+            "usage: crc32c-merge [-e CRC] [MANIFEST]\n"
+            "\n"
+            "Reads a manifest of \"LENGTH CRC\" lines, one per shard, from MANIFEST or standard\n"
+            "input, and prints \"total LENGTH CRC\" for the concatenated shards. If the manifest\n"
+            "has a \"total LENGTH CRC\" line, checks that it matches.\n"
+            "  -e  also check that the object CRC is CRC\n");
+    exit(2);
+}
+
+int main(int argc, char* argv[]) {
+    bool hasExpected = false;
+    uint32_t expected = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "e:")) != -1) {
+        char* end;
+        switch (option) {
+            case 'e':
+                expected = (uint32_t) strtoul(optarg, &end, 16);
+                if (end == optarg || *end != '\0') usage();
+                hasExpected = true;
+                break;
+            default:
+                usage();
+        }
+    }
+    if (argc - optind > 1) usage();
+
+    const char* path = optind < argc ? argv[optind] : "-";
+    int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    Crc32cManifest manifest;
+    if (fd < 0 || !manifest.read(fd)) {
+        if (fd >= 0 && errno == EINVAL) {
+            fprintf(stderr, "crc32c-merge: %s:%zu: malformed line\n", path, manifest.errorLine());
+        } else {
+            fprintf(stderr, "crc32c-merge: %s: %s\n", path, strerror(errno));
+        }
+        return 1;
+    }
+    if (fd != STDIN_FILENO) close(fd);
+
+    printf("total %" PRIu64 " %08x\n", manifest.objectLength(), manifest.objectCrc());
+    bool success = manifest.consistent();
+    if (!success) {
+        fprintf(stderr, "crc32c-merge: %s: recorded total %" PRIu64 " %08x does not match\n",
+                path, manifest.recordedLength(), manifest.recordedCrc());
+    }
+    if (hasExpected && expected != manifest.objectCrc()) {
+        fprintf(stderr, "crc32c-merge: %s: expected CRC %08x does not match\n", path, expected);
+        success = false;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+// Copyright 2008,2009,2010 Massachusetts Institute of Technology.
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Pipeline filter: copies standard input to standard output, and writes the CRC32C of the stream
+// to another file descriptor.
+//
+//   producer | crc32c-tee -f 3 -n 1G 3>stream.crc | consumer
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "crc32c_tee.h"
+
+using namespace logging;
+
+static void usage() {
+    fprintf(stderr,
+            "usage: crc32c-tee [-f FD] [-n BYTES]\n"
+            "\n"
+            "Copies standard input to standard output. At the end, writes \"total LENGTH CRC\" to\n"
+            "file descriptor FD (default 2, standard error).\n"
+            "  -n  also write \"OFFSET CRC\", the CRC of the first OFFSET bytes, every BYTES bytes.\n"
+            "      BYTES may end in K, M or G.\n");
+    exit(2);
+}
+
+static void writeCheckpoint(void* context, uint64_t offset, uint32_t crc) {
+    FILE* side = (FILE*) context;
+    fprintf(side, "%" PRIu64 " %08x\n", offset, crc);
+    fflush(side);
+}
+
+int main(int argc, char* argv[]) {
+    int sideFd = STDERR_FILENO;
+    uint64_t interval = 0;
+
+    int option;
+    while ((option = getopt(argc, argv, "f:n:")) != -1) {
+        char* end;
+        switch (option) {
+            case 'f':
+                sideFd = (int) strtol(optarg, &end, 10);
+                if (end == optarg || *end != '\0' || sideFd < 0) usage();
+                break;
+            case 'n':
+                interval = strtoull(optarg, &end, 0);
+                if (*end != '\0') {
+                    const char* SUFFIXES = "KMG";
+                    const char* suffix = strchr(SUFFIXES, *end);
+                    if (suffix == NULL || end[1] != '\0') usage();
+                    interval <<= 10 * (suffix - SUFFIXES + 1);
+                }
+                if (interval == 0) usage();
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind != argc) usage();
+
+    FILE* side = fdopen(sideFd, "w");
+    if (side == NULL) {
+        fprintf(stderr, "crc32c-tee: fd %d: %s\n", sideFd, strerror(errno));
+        return 1;
+    }
+    uint32_t crc;
+    uint64_t length;
+    if (!crc32cTee(STDIN_FILENO, STDOUT_FILENO, &crc, &length, interval, &writeCheckpoint,
+            side)) {
+        fprintf(stderr, "crc32c-tee: %s\n", strerror(errno));
+        return 1;
+    }
+    fprintf(side, "total %" PRIu64 " %08x\n", length, crc);
+    return fclose(side) == 0 ? 0 : 1;
+}